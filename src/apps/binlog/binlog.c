@@ -0,0 +1,154 @@
+/*
+ * Records in the ring buffer and on the serial line:
+ *
+ *   module, line low byte, line high 4 bits | argument count << 4,
+ *   arguments as zigzag varints
+ *
+ * In the ring each record is preceded by its length. The drain process
+ * sends whole records, base64 encoded, in lines of "#B" plus at most
+ * LINE_BYTES bytes. Module 0 line 0 reports the number of records
+ * dropped because the ring was full.
+ */
+
+#include "contiki.h"
+/* Module 0 is the log itself */
+#define BINLOG_MODULE 0
+#include "binlog.h"
+#include <stdarg.h>
+
+#if BINLOG_ENABLED
+
+#define RECORD_MAX (3 + 5 * BINLOG_MAX_ARGS)
+
+/* Record bytes per serial line: room for the largest record after a
+   dropped count, a multiple of 3 for base64 */
+#define LINE_BYTES 60
+
+static uint8_t ring[BINLOG_SIZE];
+static uint16_t head, used;
+static uint16_t dropped;
+
+PROCESS(binlog_process, "Binary log");
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_varint(uint8_t *p, int32_t v)
+{
+  uint32_t z = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+
+  while(z >= 0x80) {
+    *p++ = (z & 0x7f) | 0x80;
+    z >>= 7;
+  }
+  *p++ = z;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_header(uint8_t *p, uint8_t module, uint16_t line, uint8_t n)
+{
+  *p++ = module;
+  *p++ = line & 0xff;
+  *p++ = ((line >> 8) & 0x0f) | (n << 4);
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+void
+binlog_write(uint8_t module, uint16_t line, uint8_t n, ...)
+{
+  uint8_t rec[RECORD_MAX], *p;
+  uint16_t len, i, pos;
+  va_list ap;
+
+  p = put_header(rec, module, line, n);
+  va_start(ap, n);
+  for(i = 0; i < n; i++) {
+    p = put_varint(p, va_arg(ap, int32_t));
+  }
+  va_end(ap);
+  len = p - rec;
+
+  if(used + len + 1 > BINLOG_SIZE) {
+    dropped++;
+    return;
+  }
+  pos = (head + used) % BINLOG_SIZE;
+  ring[pos] = len;
+  for(i = 0; i < len; i++) {
+    ring[(pos + 1 + i) % BINLOG_SIZE] = rec[i];
+  }
+  used += len + 1;
+
+  if(!process_is_running(&binlog_process)) {
+    process_start(&binlog_process, NULL);
+  }
+  process_poll(&binlog_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_base64(const uint8_t *buf, uint16_t len)
+{
+  static const char digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint32_t v;
+  uint16_t i;
+
+  for(i = 0; i < len; i += 3) {
+    v = (uint32_t)buf[i] << 16;
+    if(i + 1 < len) {
+      v |= (uint16_t)buf[i + 1] << 8;
+    }
+    if(i + 2 < len) {
+      v |= buf[i + 2];
+    }
+    putchar(digits[(v >> 18) & 0x3f]);
+    putchar(digits[(v >> 12) & 0x3f]);
+    putchar(i + 1 < len ? digits[(v >> 6) & 0x3f] : '=');
+    putchar(i + 2 < len ? digits[v & 0x3f] : '=');
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Send the buffered records, one line at a time */
+static void
+drain(void)
+{
+  static uint8_t line[LINE_BYTES];
+  uint16_t len, n, i;
+
+  while(used > 0 || dropped > 0) {
+    n = 0;
+    if(dropped > 0) {
+      n = put_varint(put_header(line, 0, 0, 1), dropped) - line;
+      dropped = 0;
+    }
+    while(used > 0) {
+      len = ring[head];
+      if(n + len > LINE_BYTES) {
+        break;
+      }
+      for(i = 0; i < len; i++) {
+        line[n++] = ring[(head + 1 + i) % BINLOG_SIZE];
+      }
+      head = (head + len + 1) % BINLOG_SIZE;
+      used -= len + 1;
+    }
+    putchar('#');
+    putchar('B');
+    put_base64(line, n);
+    putchar('\n');
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(binlog_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    drain();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+
+#endif /* BINLOG_ENABLED */
@@ -0,0 +1,101 @@
+/*
+ * Binary logging. BINLOG() takes the same arguments as printf(), but
+ * with BINLOG_CONF_ENABLED (make BINLOG=1) the mote does no formatting:
+ * the call stores the source line and the raw arguments in a ring
+ * buffer, and a process later sends the buffered records over the
+ * serial line as base64 text lines starting with "#B". The host tool
+ * src/tools/binlog-decode rebuilds the printf text from them with the
+ * format table binlog.fmt, which the build extracts from the sources:
+ *
+ *   make BINLOG=1 login | ../../tools/binlog-decode binlog.fmt
+ *   ../../tools/binlog-decode binlog.fmt < COOJA.testlog
+ *
+ * Without BINLOG_CONF_ENABLED, BINLOG() is printf().
+ *
+ * Arguments must be integers or characters (%d %i %u %x %X %o %c, with
+ * an optional l); there are at most BINLOG_MAX_ARGS of them. Strings
+ * cannot be logged this way, keep printf() for those; a longer line can
+ * be written by several calls, the last one ending in "\n". BINLOG()
+ * must not be called from interrupts.
+ *
+ * Each file that logs defines its module number before including this
+ * header. Numbers in use:
+ *   3  assignment_03    5  assignment_05    7  rpl-udp server
+ *   4  assignment_04    6  rpl-udp client
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += binlog
+ *   code:      #define BINLOG_MODULE 5
+ *              #include "binlog.h"
+ *              BINLOG("[tx] node=%u -> %u id=%u\n", node_id, next_hop, seq);
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+#include "contiki.h"
+#include <stdio.h>
+
+#ifdef BINLOG_CONF_ENABLED
+#define BINLOG_ENABLED BINLOG_CONF_ENABLED
+#else
+#define BINLOG_ENABLED 0
+#endif
+
+/* Bytes of records buffered for the serial line. When it is full,
+   records are dropped and the number dropped is logged. */
+#ifdef BINLOG_CONF_SIZE
+#define BINLOG_SIZE BINLOG_CONF_SIZE
+#else
+#define BINLOG_SIZE 256
+#endif
+
+#define BINLOG_MAX_ARGS 10
+
+#if BINLOG_ENABLED
+
+#ifndef BINLOG_MODULE
+#error "define BINLOG_MODULE before including binlog.h"
+#endif
+
+/* Pick the BINLOG_<n> macro by the number of arguments after the format */
+#define BINLOG(...) BINLOG_PICK(__VA_ARGS__, BINLOG_10, BINLOG_9, BINLOG_8, \
+    BINLOG_7, BINLOG_6, BINLOG_5, BINLOG_4, BINLOG_3, BINLOG_2, BINLOG_1, \
+    BINLOG_0, 0)(__VA_ARGS__)
+#define BINLOG_PICK(f, a, b, c, d, e, g, h, i, j, k, m, ...) m
+
+#define BINLOG_W(n, ...) binlog_write(BINLOG_MODULE, __LINE__, n, __VA_ARGS__)
+#define BINLOG_0(f) binlog_write(BINLOG_MODULE, __LINE__, 0)
+#define BINLOG_1(f, a) BINLOG_W(1, (int32_t)(a))
+#define BINLOG_2(f, a, b) BINLOG_W(2, (int32_t)(a), (int32_t)(b))
+#define BINLOG_3(f, a, b, c) BINLOG_W(3, (int32_t)(a), (int32_t)(b), (int32_t)(c))
+#define BINLOG_4(f, a, b, c, d) BINLOG_W(4, (int32_t)(a), (int32_t)(b), \
+    (int32_t)(c), (int32_t)(d))
+#define BINLOG_5(f, a, b, c, d, e) BINLOG_W(5, (int32_t)(a), (int32_t)(b), \
+    (int32_t)(c), (int32_t)(d), (int32_t)(e))
+#define BINLOG_6(f, a, b, c, d, e, g) BINLOG_W(6, (int32_t)(a), (int32_t)(b), \
+    (int32_t)(c), (int32_t)(d), (int32_t)(e), (int32_t)(g))
+#define BINLOG_7(f, a, b, c, d, e, g, h) BINLOG_W(7, (int32_t)(a), \
+    (int32_t)(b), (int32_t)(c), (int32_t)(d), (int32_t)(e), (int32_t)(g), \
+    (int32_t)(h))
+#define BINLOG_8(f, a, b, c, d, e, g, h, i) BINLOG_W(8, (int32_t)(a), \
+    (int32_t)(b), (int32_t)(c), (int32_t)(d), (int32_t)(e), (int32_t)(g), \
+    (int32_t)(h), (int32_t)(i))
+#define BINLOG_9(f, a, b, c, d, e, g, h, i, j) BINLOG_W(9, (int32_t)(a), \
+    (int32_t)(b), (int32_t)(c), (int32_t)(d), (int32_t)(e), (int32_t)(g), \
+    (int32_t)(h), (int32_t)(i), (int32_t)(j))
+#define BINLOG_10(f, a, b, c, d, e, g, h, i, j, k) BINLOG_W(10, (int32_t)(a), \
+    (int32_t)(b), (int32_t)(c), (int32_t)(d), (int32_t)(e), (int32_t)(g), \
+    (int32_t)(h), (int32_t)(i), (int32_t)(j), (int32_t)(k))
+
+/* Record n int32_t arguments for the BINLOG() call at line of module */
+void binlog_write(uint8_t module, uint16_t line, uint8_t n, ...);
+
+#else /* BINLOG_ENABLED */
+
+#define BINLOG(...) printf(__VA_ARGS__)
+
+#endif /* BINLOG_ENABLED */
+
+#endif /* BINLOG_H_ */
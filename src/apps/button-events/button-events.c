@@ -0,0 +1,109 @@
+/*
+ * Button state machine. The button sensor reports presses only, so a
+ * held button is polled until button_sensor.value() drops:
+ *
+ *   idle --press--> held --release--> between --timeout--> post clicks
+ *                    |                  |
+ *                    |                  +--press--> held
+ *                    +--LONG_PRESS--> post long press, wait for release
+ *
+ * Sensor events during the debounce time after an accepted press are
+ * dropped; nothing is posted to the application until the interaction
+ * is over.
+ */
+
+#include "contiki.h"
+#include "dev/button-sensor.h"
+#include "button-events.h"
+
+process_event_t button_event;
+
+static struct process *consumer;
+static struct button_event_info info;
+static clock_time_t last_press;
+
+PROCESS(button_events_process, "Button events");
+/*---------------------------------------------------------------------------*/
+void
+button_events_init(struct process *p)
+{
+  consumer = p;
+  if(button_event == 0) {
+    button_event = process_alloc_event();
+    SENSORS_ACTIVATE(button_sensor);
+    process_start(&button_events_process, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A press from the sensor that is not contact bounce */
+static int
+is_press(process_event_t ev, process_data_t data)
+{
+  if(ev != sensors_event || data != &button_sensor) {
+    return 0;
+  }
+  if(clock_time() - last_press < BUTTON_EVENTS_DEBOUNCE) {
+    return 0;
+  }
+  last_press = clock_time();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+post(uint8_t type)
+{
+  info.type = type;
+  process_post(consumer, button_event, &info);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(button_events_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t pressed_at;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(is_press(ev, data));
+    info.clicks = 0;
+
+    while(1) {
+      /* Held: wait for the release or a long press */
+      pressed_at = clock_time();
+#if BUTTON_EVENTS_POLL
+      etimer_set(&et, BUTTON_EVENTS_POLL);
+      while(button_sensor.value(0) &&
+            clock_time() - pressed_at < BUTTON_EVENTS_LONG_PRESS) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+        etimer_reset(&et);
+      }
+      if(button_sensor.value(0)) {
+        info.clicks = 0;
+        post(BUTTON_EVENT_LONG_PRESS);
+        while(button_sensor.value(0)) {
+          PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+          etimer_reset(&et);
+        }
+        break;
+      }
+#endif /* BUTTON_EVENTS_POLL */
+      if(info.clicks < 255) {
+        info.clicks++;
+      }
+
+      /* Released: another press soon continues the interaction */
+      etimer_set(&et, BUTTON_EVENTS_MULTI_CLICK);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et) || is_press(ev, data));
+      if(etimer_expired(&et)) {
+        post(info.clicks == 1 ? BUTTON_EVENT_CLICK :
+             info.clicks == 2 ? BUTTON_EVENT_DOUBLE_CLICK :
+             BUTTON_EVENT_MULTI_CLICK);
+        break;
+      }
+      etimer_stop(&et);
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,71 @@
+/*
+ * Button input events on top of button_sensor: debounce, click
+ * counting, double click and long press. A whole interaction with the
+ * button (one or more clicks, or a long press) results in a single
+ * button_event posted to the process given to button_events_init().
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += button-events
+ *   code:      button_events_init(PROCESS_CURRENT());
+ *              ...
+ *              if(ev == button_event) {
+ *                const struct button_event_info *b = data;
+ *                if(b->type == BUTTON_EVENT_LONG_PRESS) ...
+ *              }
+ */
+
+#ifndef BUTTON_EVENTS_H_
+#define BUTTON_EVENTS_H_
+
+#include "contiki.h"
+
+/* Presses closer than this to the previous one are contact bounce */
+#ifdef BUTTON_EVENTS_CONF_DEBOUNCE
+#define BUTTON_EVENTS_DEBOUNCE BUTTON_EVENTS_CONF_DEBOUNCE
+#else
+#define BUTTON_EVENTS_DEBOUNCE (CLOCK_SECOND / 20)
+#endif
+
+/* A press this soon after a release belongs to the same interaction */
+#ifdef BUTTON_EVENTS_CONF_MULTI_CLICK
+#define BUTTON_EVENTS_MULTI_CLICK BUTTON_EVENTS_CONF_MULTI_CLICK
+#else
+#define BUTTON_EVENTS_MULTI_CLICK (CLOCK_SECOND / 3)
+#endif
+
+/* Holding the button this long is a long press */
+#ifdef BUTTON_EVENTS_CONF_LONG_PRESS
+#define BUTTON_EVENTS_LONG_PRESS BUTTON_EVENTS_CONF_LONG_PRESS
+#else
+#define BUTTON_EVENTS_LONG_PRESS CLOCK_SECOND
+#endif
+
+/* Interval at which a held button is checked for release. Platforms
+ * whose button_sensor.value() does not report the pressed state set
+ * this to 0; every press then counts as a click and there are no long
+ * presses.
+ */
+#ifdef BUTTON_EVENTS_CONF_POLL
+#define BUTTON_EVENTS_POLL BUTTON_EVENTS_CONF_POLL
+#else
+#define BUTTON_EVENTS_POLL (CLOCK_SECOND / 32)
+#endif
+
+#define BUTTON_EVENT_CLICK        1
+#define BUTTON_EVENT_DOUBLE_CLICK 2
+#define BUTTON_EVENT_MULTI_CLICK  3   /* three or more, see clicks */
+#define BUTTON_EVENT_LONG_PRESS   4
+
+struct button_event_info {
+  uint8_t type;
+  uint8_t clicks;       /* clicks in the interaction */
+};
+
+/* Posted with a const struct button_event_info * as data */
+extern process_event_t button_event;
+
+/* Activate the button and deliver its events to p */
+void button_events_init(struct process *p);
+
+#endif /* BUTTON_EVENTS_H_ */
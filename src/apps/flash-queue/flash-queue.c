@@ -0,0 +1,130 @@
+#include "contiki.h"
+#include "cfs/cfs.h"
+#if FLASH_QUEUE_RESERVE
+#include "cfs/cfs-coffee.h"
+#endif
+#include "flash-queue.h"
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/* File name of segment s: the queue name and the digit of s */
+static const char *
+segment(const struct flash_queue *q, uint8_t s, char *buf)
+{
+  size_t len = strlen(q->name);
+
+  memcpy(buf, q->name, len);
+  buf[len] = '0' + s;
+  buf[len + 1] = '\0';
+  return buf;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_segment(const struct flash_queue *q, uint8_t s)
+{
+  char file[FLASH_QUEUE_NAME_MAX + 2];
+
+  cfs_remove(segment(q, s, file));
+}
+/*---------------------------------------------------------------------------*/
+int
+flash_queue_init(struct flash_queue *q, const char *name,
+                 uint16_t rec_size, uint16_t seg_recs, uint8_t segments)
+{
+  uint8_t s;
+
+  if(strlen(name) > FLASH_QUEUE_NAME_MAX || segments < 1 || segments > 10) {
+    return -1;
+  }
+  strcpy(q->name, name);
+  q->rec_size = rec_size;
+  q->seg_recs = seg_recs;
+  q->segments = segments;
+  q->head = q->tail = 0;
+  q->head_off = q->tail_len = q->count = 0;
+  for(s = 0; s < segments; s++) {
+    remove_segment(q, s);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+flash_queue_push(struct flash_queue *q, const void *rec)
+{
+  char file[FLASH_QUEUE_NAME_MAX + 2];
+  int evicted = 0, fd, n;
+
+  if(q->tail_len == q->seg_recs) {
+    q->tail = (q->tail + 1) % q->segments;
+    q->tail_len = 0;
+    if(q->tail == q->head && q->count > 0) {
+      /* Full: the oldest segment goes, with what is left of it */
+      evicted = q->seg_recs - q->head_off;
+      q->count -= evicted;
+      q->head = (q->head + 1) % q->segments;
+      q->head_off = 0;
+    }
+  }
+
+  segment(q, q->tail, file);
+  if(q->tail_len == 0) {
+    cfs_remove(file);
+#if FLASH_QUEUE_RESERVE
+    cfs_coffee_reserve(file, (cfs_offset_t)q->seg_recs * q->rec_size);
+#endif
+  }
+  fd = cfs_open(file, CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    return -1;
+  }
+  n = cfs_write(fd, rec, q->rec_size);
+  cfs_close(fd);
+  if(n != q->rec_size) {
+    return -1;
+  }
+  q->tail_len++;
+  q->count++;
+  return evicted;
+}
+/*---------------------------------------------------------------------------*/
+int
+flash_queue_peek(struct flash_queue *q, void *rec)
+{
+  char file[FLASH_QUEUE_NAME_MAX + 2];
+  int fd, n;
+
+  if(q->count == 0) {
+    return 0;
+  }
+  fd = cfs_open(segment(q, q->head, file), CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+  n = -1;
+  if(cfs_seek(fd, (cfs_offset_t)q->head_off * q->rec_size, CFS_SEEK_SET) >= 0) {
+    n = cfs_read(fd, rec, q->rec_size);
+  }
+  cfs_close(fd);
+  return n == q->rec_size;
+}
+/*---------------------------------------------------------------------------*/
+void
+flash_queue_pop(struct flash_queue *q)
+{
+  if(q->count == 0) {
+    return;
+  }
+  q->head_off++;
+  q->count--;
+  if(q->count == 0) {
+    /* Empty: start again at the beginning of the same segment */
+    remove_segment(q, q->head);
+    q->tail = q->head;
+    q->head_off = q->tail_len = 0;
+  } else if(q->head != q->tail && q->head_off == q->seg_recs) {
+    remove_segment(q, q->head);
+    q->head = (q->head + 1) % q->segments;
+    q->head_off = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
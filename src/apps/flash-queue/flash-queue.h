@@ -0,0 +1,76 @@
+/*
+ * Bounded FIFO of fixed size records in CFS (Coffee on Sky and Z1), to
+ * keep data through a time without a route and send it later.
+ *
+ * The queue is a ring of segment files, <name>0 .. <name>N-1, each
+ * holding up to seg_recs records. Records are only ever appended to the
+ * newest segment and read from the oldest, and a segment is removed as
+ * a whole once it has been read: Coffee never rewrites a page in place,
+ * which would cost it a micro log and a merge. When all segments are
+ * full, a push removes the oldest one with the records left in it, so
+ * eviction is oldest first, one segment at a time.
+ *
+ * The position in the queue is kept in RAM. flash_queue_init() removes
+ * the segments left by an earlier run.
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += flash-queue
+ *   code:      static struct flash_queue q;
+ *              flash_queue_init(&q, "sfq", sizeof(struct rec), 32, 4);
+ *              flash_queue_push(&q, &r);
+ *              while(flash_queue_peek(&q, &r)) {
+ *                ...
+ *                flash_queue_pop(&q);
+ *              }
+ */
+
+#ifndef FLASH_QUEUE_H_
+#define FLASH_QUEUE_H_
+
+#include "contiki.h"
+
+/* Reserve the full size of a segment when it is started, so Coffee
+   does not copy the file to grow it */
+#ifdef FLASH_QUEUE_CONF_RESERVE
+#define FLASH_QUEUE_RESERVE FLASH_QUEUE_CONF_RESERVE
+#elif CONTIKI_TARGET_SKY || CONTIKI_TARGET_Z1
+#define FLASH_QUEUE_RESERVE 1
+#else
+#define FLASH_QUEUE_RESERVE 0
+#endif
+
+/* Longest name of a queue, without the segment digit */
+#define FLASH_QUEUE_NAME_MAX 8
+
+struct flash_queue {
+  char name[FLASH_QUEUE_NAME_MAX + 1];
+  uint16_t rec_size;
+  uint16_t seg_recs;        /* records per segment */
+  uint8_t segments;         /* at most 10 */
+  uint8_t head;             /* segment read from */
+  uint8_t tail;             /* segment appended to */
+  uint16_t head_off;        /* records already read from head */
+  uint16_t tail_len;        /* records in tail */
+  uint16_t count;           /* records in the queue */
+};
+
+/* Start an empty queue of segments * seg_recs records of rec_size
+   bytes. Returns 0, or -1 if the name or segments are too long. */
+int flash_queue_init(struct flash_queue *q, const char *name,
+                     uint16_t rec_size, uint16_t seg_recs, uint8_t segments);
+
+/* Append a record. Returns the number of old records evicted to make
+   room, or -1 if it could not be written. */
+int flash_queue_push(struct flash_queue *q, const void *rec);
+
+/* Copy the oldest record to rec. Returns 1, or 0 if the queue is empty
+   or the record could not be read. */
+int flash_queue_peek(struct flash_queue *q, void *rec);
+
+/* Drop the oldest record */
+void flash_queue_pop(struct flash_queue *q);
+
+#define flash_queue_len(q) ((q)->count)
+
+#endif /* FLASH_QUEUE_H_ */
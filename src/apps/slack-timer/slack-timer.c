@@ -0,0 +1,72 @@
+#include "contiki.h"
+#include "lib/list.h"
+#include "slack-timer.h"
+
+/* Slack timers that have been set, expired ones included */
+LIST(timers);
+
+/*---------------------------------------------------------------------------*/
+/* Pick the expiry of t in its window and start its etimer */
+static void
+place(struct slack_timer *t)
+{
+  struct slack_timer *o;
+  clock_time_t best, offset, expire, now, d;
+
+  /* The earliest time in the window at which another timer fires: its
+     pending expiry, or for a periodic timer a later period */
+  best = t->slack + 1;
+  for(o = list_head(timers); o != NULL; o = list_item_next(o)) {
+    if(o == t || etimer_expired(&o->et)) {
+      continue;
+    }
+    offset = etimer_expiration_time(&o->et) - t->nominal;
+    if(offset > t->slack && o->interval > 0) {
+      d = t->nominal - o->nominal;
+      if(d < (clock_time_t)~0 / 2) {
+        offset = d % o->interval ? o->interval - d % o->interval : 0;
+      }
+    }
+    if(offset < best) {
+      best = offset;
+    }
+  }
+  /* Nothing to share: fire on time */
+  if(best > t->slack) {
+    best = 0;
+  }
+  expire = t->nominal + best;
+
+  /* A timer reset late may already be past its window: fire now */
+  now = clock_time();
+  if((clock_time_t)(expire - now) > t->interval + t->slack) {
+    expire = now;
+  }
+  etimer_set(&t->et, expire - now);
+  list_add(timers, t);
+}
+/*---------------------------------------------------------------------------*/
+void
+slack_timer_set(struct slack_timer *t, clock_time_t interval,
+                clock_time_t slack)
+{
+  t->interval = interval;
+  t->slack = slack;
+  t->nominal = clock_time() + interval;
+  place(t);
+}
+/*---------------------------------------------------------------------------*/
+void
+slack_timer_reset(struct slack_timer *t)
+{
+  t->nominal += t->interval;
+  place(t);
+}
+/*---------------------------------------------------------------------------*/
+void
+slack_timer_stop(struct slack_timer *t)
+{
+  etimer_stop(&t->et);
+  list_remove(timers, t);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,50 @@
+/*
+ * Event timers with slack, to share wakeups between processes. A slack
+ * timer is due at its nominal time but may fire up to slack clock ticks
+ * later. When it is set, it looks for a time in that window at which a
+ * slack timer of any process fires: the pending expiry of that timer,
+ * or one of its later periods if it is reset periodically. It fires
+ * then, or on time if there is none. Timers that expire in the same
+ * clock tick cost the CPU a single wakeup from low power mode.
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += slack-timer
+ *   code:      static struct slack_timer st;
+ *              slack_timer_set(&st, 60 * CLOCK_SECOND, 10 * CLOCK_SECOND);
+ *              while(1) {
+ *                PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st));
+ *                ...
+ *                slack_timer_reset(&st);
+ *              }
+ *
+ * The timer posts PROCESS_EVENT_TIMER to the process that set it, like
+ * an etimer, with the slack timer's etimer as data.
+ */
+
+#ifndef SLACK_TIMER_H_
+#define SLACK_TIMER_H_
+
+#include "contiki.h"
+
+struct slack_timer {
+  struct slack_timer *next;
+  struct etimer et;
+  clock_time_t nominal;       /* start of the window */
+  clock_time_t interval;
+  clock_time_t slack;
+};
+
+/* Fire interval ticks from now, or up to slack ticks later */
+void slack_timer_set(struct slack_timer *t, clock_time_t interval,
+                     clock_time_t slack);
+
+/* Fire again one interval after the previous nominal time, so a
+   periodic timer does not drift by the slack it used */
+void slack_timer_reset(struct slack_timer *t);
+
+void slack_timer_stop(struct slack_timer *t);
+
+#define slack_timer_expired(t) etimer_expired(&(t)->et)
+
+#endif /* SLACK_TIMER_H_ */
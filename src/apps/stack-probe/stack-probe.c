@@ -0,0 +1,79 @@
+#include "contiki.h"
+#include "stack-probe.h"
+#include <stdio.h>
+
+#if STACK_PROBE_ENABLED
+
+#define PATTERN 0x5aa5
+
+/* Words below the caller's frame that are left alone while filling,
+   for the frame of stack_probe_start() itself */
+#define GUARD_WORDS 16
+
+/* From the msp430 linker script: the end of .bss/.noinit, and the top
+   of RAM where the stack starts */
+extern uint16_t _end[], __stack[];
+
+static clock_time_t interval;
+static uint16_t reported;
+
+PROCESS(stack_probe_process, "Stack probe");
+/*---------------------------------------------------------------------------*/
+static uint16_t *
+lowest_used(void)
+{
+  uint16_t *p = _end;
+
+  while(p < __stack && *p == PATTERN) {
+    p++;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+stack_probe_used(void)
+{
+  return (uint8_t *)__stack - (uint8_t *)lowest_used();
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+stack_probe_free(void)
+{
+  return (uint8_t *)lowest_used() - (uint8_t *)_end;
+}
+/*---------------------------------------------------------------------------*/
+void
+stack_probe_start(clock_time_t i)
+{
+  uint16_t here, *p;
+
+  for(p = _end; p < &here - GUARD_WORDS; p++) {
+    *p = PATTERN;
+  }
+  interval = i;
+  reported = 0;
+  process_start(&stack_probe_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(stack_probe_process, ev, data)
+{
+  static struct etimer et;
+  uint16_t used;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&et, interval);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+    used = stack_probe_used();
+    if(used > reported) {
+      reported = used;
+      printf("[stack] used=%u free=%u\n", used, stack_probe_free());
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* STACK_PROBE_ENABLED */
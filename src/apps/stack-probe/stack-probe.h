@@ -0,0 +1,52 @@
+/*
+ * Stack high-water mark at run time. stack_probe_start() fills the RAM
+ * between the end of .bss/.noinit and the stack in use with a pattern;
+ * the stack overwrites it as it grows, so the first word from the
+ * bottom that no longer holds the pattern is the deepest the stack has
+ * been. Every interval the process of the probe checks it and, when it
+ * has grown, prints
+ *
+ *   [stack] used=<bytes> free=<bytes>
+ *
+ * Interrupts that come while the stack is at its deepest are counted.
+ * src/tools/stack-depth gives the static worst case to compare with.
+ *
+ * Only with STACK_PROBE_CONF_ENABLED (make STACK_PROBE=1) on msp430;
+ * otherwise the calls do nothing and report 0.
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += stack-probe
+ *   code:      #include "stack-probe.h"
+ *              stack_probe_start(60 * CLOCK_SECOND);    early at boot
+ */
+
+#ifndef STACK_PROBE_H_
+#define STACK_PROBE_H_
+
+#include "contiki.h"
+
+#if defined(STACK_PROBE_CONF_ENABLED) && defined(__MSP430__)
+#define STACK_PROBE_ENABLED STACK_PROBE_CONF_ENABLED
+#else
+#define STACK_PROBE_ENABLED 0
+#endif
+
+#if STACK_PROBE_ENABLED
+
+/* Fill the unused stack and check it every interval */
+void stack_probe_start(clock_time_t interval);
+
+/* Deepest use of the stack so far, and the bytes never reached */
+uint16_t stack_probe_used(void);
+uint16_t stack_probe_free(void);
+
+#else
+
+#define stack_probe_start(interval)
+#define stack_probe_used() 0
+#define stack_probe_free() 0
+
+#endif /* STACK_PROBE_ENABLED */
+
+#endif /* STACK_PROBE_H_ */
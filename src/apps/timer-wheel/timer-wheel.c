@@ -0,0 +1,238 @@
+/*
+ * Two level timer wheel. Level 0 has one slot per wheel tick for the
+ * next SLOTS ticks, level 1 one slot per SLOTS ticks for the next
+ * SLOTS * SLOTS ticks, tasks further out wait in an overflow list:
+ *
+ *   expire - now < SLOTS             level0[expire % SLOTS]
+ *   expire - now < SLOTS * SLOTS     level1[expire / SLOTS % SLOTS]
+ *   otherwise                        overflow
+ *
+ * Each time the wheel enters a new level 1 slot, the tasks in that slot
+ * move down to level 0; each time it enters a new round of level 1, the
+ * overflow list is sorted in again. The etimer is only set for the next
+ * tick that has tasks to run or to move down, so empty ticks cost no
+ * wakeup.
+ */
+
+#include "contiki.h"
+#include "timer-wheel.h"
+
+#ifdef TIMER_WHEEL_CONF_WAKEUP_HOOK
+/* Called each time the timer wheel process runs, for measurements */
+void TIMER_WHEEL_CONF_WAKEUP_HOOK(void);
+#endif
+
+#define BITS  5
+#define SLOTS (1 << BITS)
+#define MASK  (SLOTS - 1)
+
+static struct timer_wheel_task *level0[SLOTS];
+static struct timer_wheel_task *level1[SLOTS];
+static struct timer_wheel_task *overflow;
+/* Tasks taken out of a level 0 slot to be run */
+static struct timer_wheel_task *due;
+
+/* Wheel ticks since the start, and the clock time that tick began */
+static uint32_t now;
+static clock_time_t now_clock;
+
+static struct etimer et;
+
+PROCESS(timer_wheel_process, "Timer wheel");
+/*---------------------------------------------------------------------------*/
+static void
+push(struct timer_wheel_task **list, struct timer_wheel_task *t)
+{
+  t->next = *list;
+  t->slot = list;
+  *list = t;
+}
+/*---------------------------------------------------------------------------*/
+/* Put t in the slot for its expiry tick, which lies after now */
+static void
+queue(struct timer_wheel_task *t)
+{
+  uint32_t delta = t->expire - now;
+
+  if(delta < SLOTS) {
+    push(&level0[t->expire & MASK], t);
+  } else if(delta < (uint32_t)SLOTS * SLOTS) {
+    push(&level1[(t->expire >> BITS) & MASK], t);
+  } else {
+    push(&overflow, t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Empty list and queue its tasks again, relative to the current tick */
+static void
+requeue(struct timer_wheel_task **list)
+{
+  struct timer_wheel_task *t, *next;
+
+  t = *list;
+  *list = NULL;
+  for(; t != NULL; t = next) {
+    next = t->next;
+    queue(t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Run the tasks in the level 0 slot of the current tick */
+static void
+run_due(void)
+{
+  struct timer_wheel_task *t;
+
+  due = level0[now & MASK];
+  level0[now & MASK] = NULL;
+  for(t = due; t != NULL; t = t->next) {
+    t->slot = &due;
+  }
+
+  while(due != NULL) {
+    t = due;
+    due = t->next;
+    /* Queue the next run first, so the callback can stop the task */
+    t->expire += t->period;
+    queue(t);
+    t->callback(t->ptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Step the wheel to the current clock time, running all tasks due */
+static void
+advance(void)
+{
+  clock_time_t ticks;
+
+  ticks = (clock_time_t)(clock_time() - now_clock) / TIMER_WHEEL_TICK;
+  while(ticks-- > 0) {
+    now++;
+    now_clock += TIMER_WHEEL_TICK;
+    if((now & MASK) == 0) {
+      if((now & ((uint32_t)SLOTS * SLOTS - 1)) == 0) {
+        requeue(&overflow);
+      }
+      requeue(&level1[(now >> BITS) & MASK]);
+    }
+    if(level0[now & MASK] != NULL) {
+      run_due();
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Non-zero if the wheel has tasks to move down when it enters tick,
+   the first tick of a level 1 slot */
+static int
+moves_down(uint32_t tick)
+{
+  return level1[(tick >> BITS) & MASK] != NULL ||
+    ((tick & ((uint32_t)SLOTS * SLOTS - 1)) == 0 && overflow != NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Wheel tick at which there is work next, 0 if the wheel is empty */
+static uint32_t
+next_work(void)
+{
+  uint32_t tick;
+  int i;
+
+  /* Level 0 holds the tasks of the next SLOTS ticks */
+  for(tick = now + 1; tick <= now + SLOTS; tick++) {
+    if(level0[tick & MASK] != NULL || ((tick & MASK) == 0 && moves_down(tick))) {
+      return tick;
+    }
+  }
+  /* Further out there is only work at level 1 slot boundaries. Level 1
+     reaches SLOTS slots ahead, and the overflow list is sorted in again
+     within that span. */
+  tick = (tick + MASK) & ~(uint32_t)MASK;
+  for(i = 0; i < SLOTS; i++, tick += SLOTS) {
+    if(moves_down(tick)) {
+      return tick;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Set the etimer for the next tick with work */
+static void
+schedule(void)
+{
+  uint32_t next = next_work();
+
+  if(next == 0) {
+    etimer_stop(&et);
+    return;
+  }
+  etimer_set(&et, (clock_time_t)(next - now) * TIMER_WHEEL_TICK -
+             (clock_time_t)(clock_time() - now_clock));
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_set(struct timer_wheel_task *t, clock_time_t period,
+                void (*callback)(void *), void *ptr)
+{
+  uint32_t current;
+  uint16_t p;
+
+  if(!process_is_running(&timer_wheel_process)) {
+    now = 0;
+    now_clock = clock_time();
+    process_start(&timer_wheel_process, NULL);
+  }
+
+  timer_wheel_stop(t);
+
+  p = (period + TIMER_WHEEL_TICK / 2) / TIMER_WHEEL_TICK;
+  if(p == 0) {
+    p = 1;
+  }
+  t->period = p;
+  t->callback = callback;
+  t->ptr = ptr;
+
+  /* First run at the next multiple of the period. The wheel may be
+     behind the clock if it has been sleeping. */
+  current = now + (clock_time_t)(clock_time() - now_clock) / TIMER_WHEEL_TICK;
+  t->expire = (current / p + 1) * p;
+  queue(t);
+
+  /* Let the process set its etimer again if this task is due first */
+  process_poll(&timer_wheel_process);
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_wheel_stop(struct timer_wheel_task *t)
+{
+  struct timer_wheel_task **p;
+
+  if(t->slot == NULL) {
+    return;
+  }
+  for(p = t->slot; *p != NULL; p = &(*p)->next) {
+    if(*p == t) {
+      *p = t->next;
+      break;
+    }
+  }
+  t->slot = NULL;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(timer_wheel_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+#ifdef TIMER_WHEEL_CONF_WAKEUP_HOOK
+    TIMER_WHEEL_CONF_WAKEUP_HOOK();
+#endif
+    advance();
+    schedule();
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL ||
+                             (ev == PROCESS_EVENT_TIMER && data == &et));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,54 @@
+/*
+ * Periodic callbacks for many tasks on a single etimer. Tasks sit in a
+ * two level timer wheel; one process sleeps on one etimer until the
+ * next tick that has work, then runs every task due in that tick.
+ *
+ * Periods are rounded to whole wheel ticks and every task first runs
+ * at a multiple of its period counted from when the wheel started.
+ * Tasks whose periods share a factor therefore come due in the same
+ * tick and are served by one wakeup (a 3 s and a 6 s task meet every
+ * 6 s, a 3 s and a 5 s task every 15 s).
+ *
+ * To use it in an application:
+ *   Makefile:  APPDIRS += <path to src/apps>
+ *              APPS += timer-wheel
+ *   code:      static struct timer_wheel_task t;
+ *              timer_wheel_set(&t, 3 * CLOCK_SECOND, callback, ptr);
+ *
+ * Callbacks run in the context of the timer wheel process, like ctimer
+ * callbacks. They may set or stop any task, their own included.
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include "contiki.h"
+
+/* Length of a wheel tick in clock ticks. Deadlines are rounded to it. */
+#ifdef TIMER_WHEEL_CONF_TICK
+#define TIMER_WHEEL_TICK TIMER_WHEEL_CONF_TICK
+#else
+#define TIMER_WHEEL_TICK (CLOCK_SECOND / 8)
+#endif
+
+struct timer_wheel_task {
+  struct timer_wheel_task *next;
+  struct timer_wheel_task **slot;   /* list the task is in, NULL if stopped */
+  void (*callback)(void *ptr);
+  void *ptr;
+  uint32_t expire;                  /* wheel tick of the next run */
+  uint16_t period;                  /* in wheel ticks */
+};
+
+/* Run callback(ptr) every period clock ticks until stopped. Restarts
+   the task if it is already set. */
+void timer_wheel_set(struct timer_wheel_task *t, clock_time_t period,
+                     void (*callback)(void *), void *ptr);
+
+/* Stop a task; does nothing if it is not set */
+void timer_wheel_stop(struct timer_wheel_task *t);
+
+/* Non-zero if the task is set */
+#define timer_wheel_is_set(t) ((t)->slot != NULL)
+
+#endif /* TIMER_WHEEL_H_ */
@@ -1,5 +1,6 @@
 #include "contiki.h"
 #include "dev/leds.h"
+#include "led-stats.h"
 #include <stdio.h>
 
 PROCESS(thread1_process, "Thread 1 - RED LED");
@@ -15,16 +16,27 @@ PROCESS_THREAD(thread1_process, ev, data)
 
   PROCESS_BEGIN();
 
+  led_stats_init();
+
   etimer_set(&timer1, CLOCK_SECOND * 3);
 
   while(1) {
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer1));
+    /* Same as PROCESS_WAIT_EVENT_UNTIL(), but counts every time the
+       thread runs, also for events that do not end the wait */
+    PROCESS_WAIT_EVENT();
+    led_stats_wakeup();
+    if(!etimer_expired(&timer1)) {
+      continue;
+    }
 
     leds_toggle(LEDS_RED);
+    led_stats_toggle();
+#if LED_VERBOSE
     printf("[Thread 1][%lu s] i = %d | RED LED %s\n", 
            clock_seconds(), 
            i, 
            (leds_get() & LEDS_RED) ? "ON" : "OFF");
+#endif
 
     i += 2;
     etimer_reset(&timer1);
@@ -42,16 +54,26 @@ PROCESS_THREAD(thread2_process, ev, data)
 
   PROCESS_BEGIN();
 
+  led_stats_init();
+
   etimer_set(&timer2, CLOCK_SECOND * 5);
 
   while(1) {
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer2));
+    /* Counted wait, as in thread 1 */
+    PROCESS_WAIT_EVENT();
+    led_stats_wakeup();
+    if(!etimer_expired(&timer2)) {
+      continue;
+    }
 
     leds_toggle(LEDS_GREEN);
+    led_stats_toggle();
+#if LED_VERBOSE
     printf("[Thread 2][%lu s] j = %d | GREEN LED %s\n", 
            clock_seconds(), 
            j,
            (leds_get() & LEDS_GREEN) ? "ON" : "OFF");
+#endif
 
     j += 5;
     etimer_reset(&timer2);
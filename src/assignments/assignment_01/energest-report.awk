@@ -0,0 +1,25 @@
+# Summarise the last ENERGEST line of a Cooja test log, see led-stats.h.
+# Usage: awk -v name=<program> -f energest-report.awk COOJA.testlog
+
+/ENERGEST t=/ {
+  for(i = 1; i <= NF; i++) {
+    if(split($i, kv, "=") == 2) {
+      v[kv[1]] = kv[2]
+    }
+  }
+  found = 1
+}
+
+END {
+  if(!found) {
+    printf "%-18s no ENERGEST report in the log\n", name
+    exit 1
+  }
+  us = 1000000 / v["hz"]
+  cpu = v["cpu"] * us
+  printf "%-18s %5d s  cpu %9.0f us (%.4f%%)  toggles %5d  wakeups %5d  cpu/toggle %7.1f us  cpu/wakeup %7.1f us\n",
+    name, v["t"], cpu, 100 * v["cpu"] / (v["cpu"] + v["lpm"]),
+    v["toggles"], v["wakeups"],
+    v["toggles"] ? cpu / v["toggles"] : 0,
+    v["wakeups"] ? cpu / v["wakeups"] : 0
+}
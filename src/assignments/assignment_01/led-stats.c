@@ -0,0 +1,101 @@
+#include "contiki.h"
+#include "sys/energest.h"
+#include "led-stats.h"
+#include <stdio.h>
+
+static struct {
+  struct process *p;
+  unsigned long wakeups;
+} procs[LED_STATS_PROCESSES];
+
+static unsigned long toggles, wakeups;
+static unsigned long cpu_start, lpm_start;
+static unsigned long seconds_start;
+static uint16_t to_report;          /* seconds until the next report */
+static uint8_t started;
+static struct ctimer report_timer;
+
+/* clock_time_t is 16 bits on Sky: the timer is set for at most STEP
+   seconds at a time (65535 ticks is 511 s), so a long period is waited
+   out in steps */
+#define STEP 256
+
+/*---------------------------------------------------------------------------*/
+static void report(void *ptr);
+
+static void
+wait_step(void)
+{
+  uint16_t s = to_report < STEP ? to_report : STEP;
+
+  ctimer_set(&report_timer, (clock_time_t)s * CLOCK_SECOND, report, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+report(void *ptr)
+{
+  unsigned long cpu, lpm;
+  int i;
+
+  to_report -= to_report < STEP ? to_report : STEP;
+  if(to_report > 0) {
+    wait_step();
+    return;
+  }
+  to_report = LED_STATS_PERIOD;
+  wait_step();
+
+  energest_flush();
+  cpu = energest_type_time(ENERGEST_TYPE_CPU) - cpu_start;
+  lpm = energest_type_time(ENERGEST_TYPE_LPM) - lpm_start;
+
+  printf("ENERGEST t=%lu hz=%lu cpu=%lu lpm=%lu toggles=%lu wakeups=%lu (",
+         clock_seconds() - seconds_start,
+         (unsigned long)RTIMER_SECOND, cpu, lpm, toggles, wakeups);
+  for(i = 0; i < LED_STATS_PROCESSES && procs[i].p != NULL; i++) {
+    printf("%s%s: %lu", i > 0 ? ", " : "",
+           PROCESS_NAME_STRING(procs[i].p), procs[i].wakeups);
+  }
+  printf(")\n");
+}
+/*---------------------------------------------------------------------------*/
+void
+led_stats_init(void)
+{
+  /* Only the first caller starts the report, the programs with several
+     processes call this from each of them */
+  if(started) {
+    return;
+  }
+  started = 1;
+  energest_flush();
+  cpu_start = energest_type_time(ENERGEST_TYPE_CPU);
+  lpm_start = energest_type_time(ENERGEST_TYPE_LPM);
+  seconds_start = clock_seconds();
+  to_report = LED_STATS_PERIOD;
+  wait_step();
+}
+/*---------------------------------------------------------------------------*/
+void
+led_stats_wakeup(void)
+{
+  struct process *p = PROCESS_CURRENT();
+  int i;
+
+  wakeups++;
+  for(i = 0; i < LED_STATS_PROCESSES; i++) {
+    if(procs[i].p == p || procs[i].p == NULL) {
+      procs[i].p = p;
+      procs[i].wakeups++;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+led_stats_toggle(void)
+{
+  toggles++;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,47 @@
+#ifndef LED_STATS_H_
+#define LED_STATS_H_
+
+#include "contiki.h"
+
+/*
+ * CPU cost accounting for the LED programs. Every LED_STATS_PERIOD
+ * seconds a line
+ *
+ *   ENERGEST t=<s> hz=<ticks/s> cpu=<ticks> lpm=<ticks> toggles=<n> wakeups=<n> (<process>: <n>, ...)
+ *
+ * is printed with the energest CPU and LPM time, the number of LED toggles
+ * and the number of times each process ran, all counted since
+ * led_stats_init().
+ */
+
+/* Seconds between two report lines, at most 65535 */
+#ifdef LED_STATS_CONF_PERIOD
+#define LED_STATS_PERIOD LED_STATS_CONF_PERIOD
+#else
+#define LED_STATS_PERIOD 60
+#endif
+#if LED_STATS_PERIOD < 1 || LED_STATS_PERIOD > 65535
+#error "LED_STATS_PERIOD must be 1 to 65535 seconds"
+#endif
+
+/* Print a line for every toggle. Turned off when benchmarking, so the
+   serial output does not dwarf the scheduling cost. */
+#ifdef LED_CONF_VERBOSE
+#define LED_VERBOSE LED_CONF_VERBOSE
+#else
+#define LED_VERBOSE 1
+#endif
+
+/* Processes that get a wakeup counter */
+#define LED_STATS_PROCESSES 4
+
+/* Start counting and reporting */
+void led_stats_init(void);
+
+/* Count a wakeup of the current process, call right after every wait */
+void led_stats_wakeup(void);
+
+/* Count an LED toggle */
+void led_stats_toggle(void);
+
+#endif /* LED_STATS_H_ */
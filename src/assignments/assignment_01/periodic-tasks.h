@@ -0,0 +1,28 @@
+#ifndef PERIODIC_TASKS_H_
+#define PERIODIC_TASKS_H_
+
+#include "contiki.h"
+#include "dev/leds.h"
+
+/*
+ * The task set of the timer benchmark: periodic_etimer.c runs it with
+ * one etimer per task, periodic_wheel.c on the timer wheel. Each run
+ * toggles one LED. Both start all tasks together, so they run the same
+ * schedule and only the timer mechanism differs.
+ */
+static const clock_time_t task_periods[] = {
+  CLOCK_SECOND / 2, CLOCK_SECOND * 3 / 4, CLOCK_SECOND, CLOCK_SECOND * 3 / 2,
+  CLOCK_SECOND * 2, CLOCK_SECOND * 5 / 2, CLOCK_SECOND * 3, CLOCK_SECOND * 4,
+  CLOCK_SECOND * 5, CLOCK_SECOND * 6, CLOCK_SECOND * 7, CLOCK_SECOND * 8,
+  CLOCK_SECOND * 9, CLOCK_SECOND * 10, CLOCK_SECOND * 12, CLOCK_SECOND * 15,
+  CLOCK_SECOND * 20, CLOCK_SECOND * 24, CLOCK_SECOND * 28, CLOCK_SECOND * 30,
+  CLOCK_SECOND * 45, CLOCK_SECOND * 60, CLOCK_SECOND * 90, CLOCK_SECOND * 120,
+};
+
+#define TASKS (sizeof(task_periods) / sizeof(task_periods[0]))
+
+static const unsigned char task_leds[] = { LEDS_RED, LEDS_GREEN, LEDS_BLUE };
+
+#define TASK_LED(i) task_leds[(i) % sizeof(task_leds)]
+
+#endif /* PERIODIC_TASKS_H_ */
@@ -0,0 +1,38 @@
+#include "contiki.h"
+#include "dev/leds.h"
+#include "led-stats.h"
+#include "periodic-tasks.h"
+
+/* The task set of periodic-tasks.h with one etimer per task, checked
+   after every event as in single_thread_led.c */
+PROCESS(periodic_etimer_process, "Periodic tasks on etimers");
+AUTOSTART_PROCESSES(&periodic_etimer_process);
+
+PROCESS_THREAD(periodic_etimer_process, ev, data)
+{
+  static struct etimer timers[TASKS];
+  static int i;
+
+  PROCESS_BEGIN();
+
+  led_stats_init();
+
+  for(i = 0; i < TASKS; i++) {
+    etimer_set(&timers[i], task_periods[i]);
+  }
+
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    led_stats_wakeup();
+
+    for(i = 0; i < TASKS; i++) {
+      if(etimer_expired(&timers[i])) {
+        leds_toggle(TASK_LED(i));
+        led_stats_toggle();
+        etimer_reset(&timers[i]);
+      }
+    }
+  }
+
+  PROCESS_END();
+}
@@ -0,0 +1,40 @@
+#include "contiki.h"
+#include "dev/leds.h"
+#include "timer-wheel.h"
+#include "led-stats.h"
+#include "periodic-tasks.h"
+
+/* The task set of periodic-tasks.h on the timer wheel. Wakeups are
+   counted by the timer wheel process, see project-conf.h. */
+PROCESS(periodic_wheel_process, "Periodic tasks on the timer wheel");
+AUTOSTART_PROCESSES(&periodic_wheel_process);
+
+static struct timer_wheel_task tasks[TASKS];
+
+/*---------------------------------------------------------------------------*/
+static void
+run_task(void *ptr)
+{
+  struct timer_wheel_task *t = ptr;
+
+  leds_toggle(TASK_LED(t - tasks));
+  led_stats_toggle();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(periodic_wheel_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  led_stats_init();
+
+  for(i = 0; i < TASKS; i++) {
+    timer_wheel_set(&tasks[i], task_periods[i], run_task, &tasks[i]);
+  }
+
+  /* The timer wheel runs the tasks from here on */
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,19 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Account CPU and LPM time, see led-stats.c */
+#undef ENERGEST_CONF_ON
+#define ENERGEST_CONF_ON 1
+
+/* The LED programs do not use the radio. Without duty cycling the radio
+   never wakes the CPU, so energest only sees the LED scheduling. */
+#undef NETSTACK_CONF_RDC
+#define NETSTACK_CONF_RDC nullrdc_driver
+#undef NETSTACK_CONF_MAC
+#define NETSTACK_CONF_MAC nullmac_driver
+
+/* Count the runs of the timer wheel process as wakeups in the report of
+   periodic_wheel */
+#define TIMER_WHEEL_CONF_WAKEUP_HOOK led_stats_wakeup
+
+#endif /* PROJECT_CONF_H_ */
@@ -1,5 +1,6 @@
 #include "contiki.h"
 #include "dev/leds.h"
+#include "led-stats.h"
 #include <stdio.h>
 
 PROCESS(led_toggle_process, "LED Toggle with Single Thread");
@@ -11,18 +12,24 @@ PROCESS_THREAD(led_toggle_process, ev, data)
 
   PROCESS_BEGIN();
 
+  led_stats_init();
+
   etimer_set(&timer_red, CLOCK_SECOND * 3);
   etimer_set(&timer_green, CLOCK_SECOND * 5);
 
   while(1) {
     PROCESS_WAIT_EVENT();
+    led_stats_wakeup();
 
     if(etimer_expired(&timer_red)) {
 
       leds_toggle(LEDS_RED);
+      led_stats_toggle();
+#if LED_VERBOSE
       printf("[%lu s] RED LED %s\n", 
       clock_seconds(),
       (leds_get() & LEDS_RED) ? "ON" : "OFF");
+#endif
 
       etimer_reset(&timer_red); 
     }
@@ -30,9 +37,12 @@ PROCESS_THREAD(led_toggle_process, ev, data)
     if(etimer_expired(&timer_green)) {
 
       leds_toggle(LEDS_GREEN);
+      led_stats_toggle();
+#if LED_VERBOSE
       printf("[%lu s] GREEN LED %s\n", 
       clock_seconds(),
       (leds_get() & LEDS_GREEN) ? "ON" : "OFF");
+#endif
 
       etimer_reset(&timer_green);
     }
@@ -40,4 +50,3 @@ PROCESS_THREAD(led_toggle_process, ev, data)
 
   PROCESS_END();
 }
-
@@ -37,6 +37,8 @@
 #ifdef WITH_COMPOWER
 #include "powertrace.h"
 #endif
+#define BINLOG_MODULE 6
+#include "binlog.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -83,7 +85,7 @@ send_packet(void *ptr)
   char buf[MAX_PAYLOAD_LEN];
 
   seq_id++;
-  PRINTF("DATA send to %d 'Hello %d'\n",
+  BINLOG("DATA send to %d 'Hello %d'\n",
          server_ipaddr.u8[sizeof(server_ipaddr.u8) - 1], seq_id);
   sprintf(buf, "Hello %d from the client", seq_id);
   uip_udp_packet_sendto(client_conn, buf, strlen(buf),
@@ -2,11 +2,16 @@
 #include "net/rime/rime.h"
 #include "random.h"
 #include "dev/leds.h"
+#define BINLOG_MODULE 3
+#include "binlog.h"
+#include "stack-probe.h"
 #include <stdio.h>
 #include <string.h>
 
 /* ===================== Configuration ===================== */
-#define MAX_NEIGHBORS     5                     
+#ifndef MAX_NEIGHBORS
+#define MAX_NEIGHBORS     5
+#endif
 #define NEIGHBOR_TIMEOUT  (CLOCK_SECOND * 6)   
 
 /* ================== Neighbor Data Structure ================= */
@@ -138,12 +143,12 @@ static void add_or_update_neighbor(const linkaddr_t *addr, int rssi, uint16_t se
 
 /* ==================== Print Neighbor Table ==================== */
 static void print_neighbor_table(void) {
-  printf("Node %u.%u — Neighbor stats (max %u nodes):\n",
+  BINLOG("Node %u.%u — Neighbor stats (max %u nodes):\n",
          linkaddr_node_addr.u8[0], linkaddr_node_addr.u8[1], MAX_NEIGHBORS);
-  printf("| Node |  RSSI |  PRR(%%) | RX_u | TX_est | Dup |\n");
+  BINLOG("| Node |  RSSI |  PRR(%%) | RX_u | TX_est | Dup |\n");
   for(uint8_t i = 0; i < neighbor_count; i++) {
     const neighbor_t *n = &neighbor_table[i];
-    printf("| %2u.%u | %5d | %3u.%03u | %4u | %6u | %3u |\n",
+    BINLOG("| %2u.%u | %5d | %3u.%03u | %4u | %6u | %3u |\n",
            n->addr.u8[0], n->addr.u8[1],
            n->last_rssi,
            n->prr1000/1000, n->prr1000%1000,
@@ -171,7 +176,7 @@ static void broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from) {
   /* RSSI in Contiki is stored in PACKETBUF_ATTR_RSSI */
   int rssi = (signed short)packetbuf_attr(PACKETBUF_ATTR_RSSI);
 
-  printf("RX from %u.%u: Seq=%u, SenderID=%u.%u, RSSI=%d\n",
+  BINLOG("RX from %u.%u: Seq=%u, SenderID=%u.%u, RSSI=%d\n",
          from->u8[0], from->u8[1], pkt.seq, pkt.sender_id[0], pkt.sender_id[1], rssi);
 
   add_or_update_neighbor(from, rssi, pkt.seq, clock_time());
@@ -188,6 +193,7 @@ PROCESS_THREAD(example_broadcast_process, ev, data)
   PROCESS_EXITHANDLER(broadcast_close(&broadcast);)
   PROCESS_BEGIN();
 
+  stack_probe_start(60 * CLOCK_SECOND);
   broadcast_open(&broadcast, 129, &broadcast_call);
 
   while(1) {
@@ -206,7 +212,7 @@ PROCESS_THREAD(example_broadcast_process, ev, data)
     packetbuf_copyfrom(&pkt, sizeof(pkt));
     broadcast_send(&broadcast);
 
-    printf("TX: Seq=%u, Node=%u.%u\n",
+    BINLOG("TX: Seq=%u, Node=%u.%u\n",
            pkt.seq, pkt.sender_id[0], pkt.sender_id[1]);
 
     /* Remove inactive neighbors */
@@ -3,11 +3,16 @@
 #include "random.h"
 #include "dev/leds.h"
 #include "sys/ctimer.h"
+#define BINLOG_MODULE 4
+#include "binlog.h"
+#include "stack-probe.h"
 #include <stdio.h>
 #include <string.h>
 
 /* ===================== Configuration ===================== */
-#define MAX_NEIGHBORS        3                      
+#ifndef MAX_NEIGHBORS
+#define MAX_NEIGHBORS        3
+#endif
 #define BEACON_INTERVAL      (CLOCK_SECOND * 10)    
 #define DATA_INTERVAL        (CLOCK_SECOND * 10)    
 #define OF_DECAY_INTERVAL    (CLOCK_SECOND * 20)    
@@ -105,12 +110,12 @@ static void sort_neighbors_by_rssi(void) {
 }
 
 static void print_neighbor_table(void) {
-  printf("Node %u.%u - Neighbors (max %u):\n",
+  BINLOG("Node %u.%u - Neighbors (max %u):\n",
          linkaddr_node_addr.u8[0], linkaddr_node_addr.u8[1], MAX_NEIGHBORS);
-  printf("| Addr |  RSSI |  PRR(%%) | RX_u | TX_est | RX_ctr |\n");
+  BINLOG("| Addr |  RSSI |  PRR(%%) | RX_u | TX_est | RX_ctr |\n");
   for(uint8_t i = 0; i < neighbor_count; i++) {
     const neighbor_t *n = &neighbor_table[i];
-    printf("| %u.%u | %5d | %3u.%03u | %4u | %6u | %6u |\n",
+    BINLOG("| %u.%u | %5d | %3u.%03u | %4u | %6u | %6u |\n",
            n->addr.u8[0], n->addr.u8[1],
            n->rssi,
            n->prr1000/1000, n->prr1000%1000,
@@ -217,7 +222,7 @@ static void do_rebroadcast(void *ptr) {
   if(!rb_pending) return;
   packetbuf_copyfrom(&rb_pkt_pending, sizeof(rb_pkt_pending));
   broadcast_send(&beacon_bc);
-  printf("Rebcast beacon: seq=%u hop=%u\n", rb_pkt_pending.seq, rb_pkt_pending.hop);
+  BINLOG("Rebcast beacon: seq=%u hop=%u\n", rb_pkt_pending.seq, rb_pkt_pending.hop);
   rb_pending = 0;
 }
 
@@ -258,7 +263,7 @@ static void data_recv(struct unicast_conn *c, const linkaddr_t *from) {
   memcpy(&pkt, packetbuf_dataptr(), sizeof(pkt));
 
   if(is_root_node()) {
-    printf("ROOT RX data: Seq=%u from %u.%u TTL=%u Value=%d\n",
+    BINLOG("ROOT RX data: Seq=%u from %u.%u TTL=%u Value=%d\n",
            pkt.seq, pkt.sender[0], pkt.sender[1], pkt.ttl, pkt.value);
   } else {
     if(pkt.ttl > 0) {
@@ -267,7 +272,7 @@ static void data_recv(struct unicast_conn *c, const linkaddr_t *from) {
       if(next_hop && !linkaddr_cmp(next_hop, from)) { 
         packetbuf_copyfrom(&pkt, sizeof(pkt));
         unicast_send(&data_uc, next_hop);
-        printf("FWD data: from %u.%u -> %u.%u (orig %u.%u) TTL=%u\n",
+        BINLOG("FWD data: from %u.%u -> %u.%u (orig %u.%u) TTL=%u\n",
                from->u8[0], from->u8[1], next_hop->u8[0], next_hop->u8[1],
                pkt.sender[0], pkt.sender[1], pkt.ttl);
       }
@@ -291,6 +296,7 @@ PROCESS_THREAD(tree_routing_bnn_rssi_process, ev, data)
 
   PROCESS_BEGIN();
 
+  stack_probe_start(60 * CLOCK_SECOND);
   broadcast_open(&beacon_bc, 129, &beacon_cb);
   unicast_open(&data_uc, 146, &data_cb);
 
@@ -312,7 +318,7 @@ PROCESS_THREAD(tree_routing_bnn_rssi_process, ev, data)
 
         packetbuf_copyfrom(&b, sizeof(b));
         broadcast_send(&beacon_bc);
-        printf("ROOT beacon: seq=%u\n", b.seq);
+        BINLOG("ROOT beacon: seq=%u\n", b.seq);
 
         /* helps flood filter logic across nodes */
         last_flooded_root_seq = b.seq;
@@ -334,10 +340,10 @@ PROCESS_THREAD(tree_routing_bnn_rssi_process, ev, data)
 
           packetbuf_copyfrom(&d, sizeof(d));
           unicast_send(&data_uc, next);
-          printf("TX data -> %u.%u: Seq=%u Val=%d\n",
+          BINLOG("TX data -> %u.%u: Seq=%u Val=%d\n",
                  next->u8[0], next->u8[1], d.seq, d.value);
         } else {
-          printf("No BNN available; data not sent.\n");
+          BINLOG("No BNN available; data not sent.\n");
         }
       }
       etimer_reset(&data_timer);
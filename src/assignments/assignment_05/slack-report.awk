@@ -0,0 +1,27 @@
+# Average low power mode residency over all motes, from the last
+# "[energest]" line of each mote in a Cooja test log.
+# Usage: awk -v name=<label> -f slack-report.awk COOJA.testlog
+
+/\[energest\]/ {
+  for(i = 1; i <= NF; i++) {
+    if(split($i, kv, "=") == 2) {
+      v[kv[1]] = kv[2]
+    }
+  }
+  cpu[$1] = v["cpu"]
+  lpm[$1] = v["lpm"]
+}
+
+END {
+  for(id in cpu) {
+    motes++
+    sum += lpm[id] / (cpu[id] + lpm[id])
+    total_cpu += cpu[id]
+  }
+  if(motes == 0) {
+    printf "%-10s no [energest] lines in the log\n", name
+    exit 1
+  }
+  printf "%-10s %2d motes  LPM residency %.4f%%  CPU %.0f ticks per mote\n",
+    name, motes, 100 * sum / motes, total_cpu / motes
+}
@@ -0,0 +1,105 @@
+# Metrics of one sweep run of the tree routing, see src/tools/cooja-sweep.
+# Reads a COOJA.testlog of time:mote:output lines and prints
+#   pdr            packets received by the sink / packets sent
+#   lpm_pct        mean low power mode residency of the motes, in %
+#   parent_changes parent changes per mote
+#   recv_per_min   packets received by the sinks per simulated minute
+#   sink_share_max share of those received by the busiest sink
+#   sf_stored      packets kept in flash for want of a parent
+#   sf_evicted     of those, dropped to make room for newer ones
+#   cmd_delivery   commands run by their node / commands sent by sinks
+#   cmd_tx_per_cmd radio transmissions per command (sends, hops and
+#                  flood repeats; MAC retries not counted)
+#   cmd_route_pct  share of the commands sent along a source route
+# Usage: awk -f sweep-metrics.awk COOJA.testlog
+
+{
+  split($0, f, ":")
+  mote = f[2]
+  motes[mote] = 1
+  # Simulated time, in microseconds
+  last = f[1]
+}
+
+/\[tx\] node=/ {
+  sent++
+}
+
+/\[sink\] recv/ {
+  received++
+  at_sink[mote]++
+}
+
+/\[sf\] store/ {
+  stored++
+  # A reading of the mote's own is sent only later, from flash
+  split($0, e, "src=")
+  if(e[2] + 0 == mote) {
+    sent++
+  }
+}
+
+/\[sf\] evict/ {
+  split($0, e, "n=")
+  evicted += e[2]
+}
+
+/\[cmd\] send/ {
+  cmd_sent++
+  cmd_tx++
+  if($0 !~ /route=0/) {
+    cmd_routed++
+  }
+}
+
+# The sink's own flood is counted with its send
+/\[cmd\] fwd/ || (/\[cmd\] flood/ && !/hop=0/) {
+  cmd_tx++
+}
+
+/\[cmd\] exec/ {
+  cmd_run++
+}
+
+/\[route\] parent=/ {
+  changes++
+}
+
+/\[energest\]/ {
+  for(i = 1; i <= NF; i++) {
+    if(split($i, kv, "=") == 2) {
+      v[kv[1]] = kv[2]
+    }
+  }
+  cpu[mote] = v["cpu"]
+  lpm[mote] = v["lpm"]
+}
+
+END {
+  for(m in cpu) {
+    n++
+    sum += lpm[m] / (cpu[m] + lpm[m])
+  }
+  for(m in motes) {
+    nmotes++
+  }
+  printf "pdr %.4f\n", sent ? received / sent : 0
+  if(n > 0) {
+    printf "lpm_pct %.4f\n", 100 * sum / n
+  }
+  printf "parent_changes %.2f\n", nmotes ? changes / nmotes : 0
+  printf "recv_per_min %.2f\n", (last > 0) ? received * 60e6 / last : 0
+  for(m in at_sink) {
+    if(at_sink[m] > busiest) {
+      busiest = at_sink[m]
+    }
+  }
+  printf "sink_share_max %.4f\n", received ? busiest / received : 0
+  printf "sf_stored %d\n", stored
+  printf "sf_evicted %d\n", evicted
+  if(cmd_sent > 0) {
+    printf "cmd_delivery %.4f\n", cmd_run / cmd_sent
+    printf "cmd_tx_per_cmd %.2f\n", cmd_tx / cmd_sent
+    printf "cmd_route_pct %.2f\n", 100 * cmd_routed / cmd_sent
+  }
+}
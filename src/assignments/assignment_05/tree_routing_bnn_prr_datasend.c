@@ -2,20 +2,30 @@
 #include "contiki-lib.h"
 #include "contiki-net.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <limits.h>
 #include "net/rime/rime.h"
 #include "dev/leds.h"
+#include "dev/serial-line.h"
 #include "node-id.h"
 #include "dev/sht11/sht11-sensor.h"
 #include "lib/random.h"
+#include "sys/energest.h"
+#include "slack-timer.h"
+#define BINLOG_MODULE 5
+#include "binlog.h"
+#include "stack-probe.h"
+#include "flash-queue.h"
 
 /*==================== Message Formats ====================*/
-/* Beacon from root and forwarders */
+/* Beacon from a sink and forwarders */
 typedef struct {
   unsigned short adv_parent; 
   uint16_t       adv_hops;    
   uint16_t       adv_seq;      
+  unsigned short adv_sink;     /* sink the hops lead to */
 } beacon_msg_t;
 
 /* Application data */
@@ -24,6 +34,7 @@ typedef struct {
   uint16_t       hops;         
   uint16_t       temp_raw;    
   uint16_t       data_id;     
+  unsigned short parent;       /* src's parent, for the sink's routes */
 } data_msg_t;
 
 /* ACK for unicast data */
@@ -33,6 +44,26 @@ typedef struct {
   uint8_t        ok;          
 } ack_msg_t;
 
+/* Command from a sink, source routed along route[] or flooded */
+#define CMD_ROUTE_MAX           12
+typedef struct {
+  unsigned short origin;       /* sink that sent it */
+  uint16_t       cmd_seq;
+  uint16_t       arg;
+  uint8_t        type;
+  uint8_t        len;          /* hops in route[], 0 when flooded */
+  uint8_t        pos;          /* hop the frame is on, from 0 */
+  unsigned short dst;
+  unsigned short route[CMD_ROUTE_MAX];   /* first hop .. dst */
+} cmd_msg_t;
+
+/* Only the hops of the route go on the air */
+#define CMD_SIZE(m)             (offsetof(cmd_msg_t, route) + (m)->len * sizeof((m)->route[0]))
+
+#define CMD_PING                1
+#define CMD_T_DATA              2       /* arg: data period in seconds */
+#define CMD_DUMP                3       /* print the neighbor table */
+
 /*==================== Neighbor Record ====================*/
 typedef struct {
   unsigned short id;         
@@ -40,27 +71,78 @@ typedef struct {
   uint16_t       rx_ack;       
   int            rssi;         
   uint16_t       hops_via;     
+  unsigned short sink;         /* sink hops_via leads to */
   float          prr;          
   uint8_t        used;        
   clock_time_t   seen_at;      
 } nbr_t;
 
 /*======================== Constants =======================*/
-#define SINK_ID                 1
+/* Node ids of the sinks, comma separated (make SINKS=1:100). Each sink
+   beacons with its own id and nodes join the nearest one. */
+#ifndef SINK_IDS
+#define SINK_IDS                1
+#endif
 #define CH_BC                   128
 #define CH_DATA                 140
 #define CH_ACK                  142
+#define CH_CMD                  144
+#define CH_CMD_FLOOD            146
 #define T_STARTUP_WAIT          5
-#define T_BC                    45     
+#ifndef T_BC
+#define T_BC                    45
+#endif
+#if T_BC < 1 || T_BC > 500
+#error "T_BC must be 1 to 500 s: T_BC * CLOCK_SECOND is a 16 bit clock_time_t"
+#endif
 #define T_PRINT                 28     
+#ifndef T_DATA
 #define T_DATA                  60
+#endif
+#define T_DATA_MAX              500     /* keeps t_data * CLOCK_SECOND in 16 bits */
 #define T_RESELECT              9       
 #define T_AGING                 60
 
-#define HOPS_MAX                20
+/* Each periodic job may run up to SLACK_PCT percent of its period late,
+   so the jobs of all processes can share wakeups (see slack-timer.h).
+   0 runs every job on time. */
+#ifndef SLACK_PCT
+#define SLACK_PCT               25
+#endif
+#define SLACK(t)                ((clock_time_t)(t) * CLOCK_SECOND / 100 * SLACK_PCT)
+
+#define HOPS_MAX                20      /* [hops] prints 9, 10 and 1 bins */
 #define NBR_CAP                 10
 #define PRR_MIN_SAMPLES         3
 #define NBR_TTL                 (180 * CLOCK_SECOND)
+#define SINK_TTL                (3UL * T_BC)    /* s, sink gone */
+
+/* Data that finds no parent is kept in flash (see flash-queue.h), in
+   SF_SEGMENTS files of SF_SEG_RECS, the oldest dropped first. Once there
+   is a parent it is sent again, SF_BATCH every T_DRAIN seconds, SF_GAP
+   apart and never within SF_GAP of live data. */
+#define SF_SEGMENTS             4
+#define SF_SEG_RECS             32
+#ifndef T_DRAIN
+#define T_DRAIN                 10
+#endif
+#ifndef SF_BATCH
+#define SF_BATCH                4
+#endif
+#define SF_GAP                  (CLOCK_SECOND / 4)
+
+/* Sinks learn the parent of each node from its data and send commands
+   down the path that gives, or by flooding when the path is not known.
+   make CMD_FLOOD=1 always floods, make T_CMD=<s> has each sink ping the
+   nodes it knows in turn every T_CMD seconds. */
+#define ROUTE_CAP               64
+#define ROUTE_TTL               (240 * CLOCK_SECOND)
+#ifndef CMD_FLOOD
+#define CMD_FLOOD               0
+#endif
+#ifndef T_CMD
+#define T_CMD                   0
+#endif
 
 #define PICK_HOP                1
 #define PICK_RSSI               2
@@ -70,37 +152,67 @@ typedef struct {
 #endif
 
 /*===================== Module State ======================*/
+static const unsigned short sink_ids[] = { SINK_IDS };
+#define NSINKS                  (sizeof(sink_ids) / sizeof(sink_ids[0]))
+
 static struct broadcast_conn bc;
 static struct unicast_conn   uc_data;
 static struct unicast_conn   uc_ack;
+static struct unicast_conn   uc_cmd;
+static struct broadcast_conn bc_cmd;
 
 static unsigned short next_hop = 0;      
 static uint16_t       data_seq = 0;      
 static uint16_t       disc_seq_tx = 0;  
 static uint16_t       disc_seq_rx = 0;  
+static uint8_t        is_sink = 0;
+static uint16_t       t_data = T_DATA;
 
-static struct etimer  et0, et1, et2, et3;
+/* Per sink: last beacon sequence seen, hops from it and when (s) */
+static uint16_t       sink_seq[NSINKS];
+static uint16_t       sink_hops[NSINKS];
+static unsigned long  sink_heard[NSINKS];
+
+static struct etimer  et0;
+static struct slack_timer st0, st1, st2, st3, st4, st5;
 static struct ctimer  led_off;
 
 static nbr_t          nbrs[NBR_CAP];
 static short          hop_hist[HOPS_MAX];
 static radio_value_t  rtmp;
+static struct flash_queue sfq;
+static clock_time_t   live_at;          /* last live data sent */
+
+/* Sink: parent of each node heard from */
+typedef struct {
+  unsigned short id;
+  unsigned short parent;
+  clock_time_t   seen_at;
+} route_t;
+static route_t        routes[ROUTE_CAP];
+static uint16_t       cmd_seq_tx = 0;
+static uint16_t       cmd_seen[NSINKS];  /* last flooded command per sink */
+static cmd_msg_t      cmd_pending;       /* flood to repeat */
+static struct ctimer  cmd_jitter;
 
 /*======================== Prototypes =====================*/
 static void    led_off_cb(void);
 static void    nbr_init(void);
 static int     nbr_find(unsigned short id);
 static void    nbr_touch(nbr_t *n);
-static void    nbr_upsert(unsigned short id, int rssi, uint16_t hops);
+static void    nbr_upsert(unsigned short id, int rssi, uint16_t hops,
+                          unsigned short sink);
 static void    nbr_expire(void);
 static void    prr_bump(unsigned short id, uint8_t got_ack);
 static void    parent_set(unsigned short id);
 static void    data_send(data_msg_t *m);
-static void    temp_print(uint16_t raw);
+static void    data_store(data_msg_t *m);
 
 static void    cb_bc(struct broadcast_conn *c, linkaddr_t *from);
 static void    cb_uc_data(struct unicast_conn *c, const linkaddr_t *from);
 static void    cb_uc_ack(struct unicast_conn *c, const linkaddr_t *from);
+static void    cb_uc_cmd(struct unicast_conn *c, const linkaddr_t *from);
+static void    cb_bc_cmd(struct broadcast_conn *c, const linkaddr_t *from);
 
 static void    parent_reselect(void);
 
@@ -109,16 +221,36 @@ PROCESS(proc_route,  "Routing / Beacon");
 PROCESS(proc_data,   "Data TX/RX");
 PROCESS(proc_pick,   "Parent Selection");
 PROCESS(proc_stats,  "Stats / Debug");
+PROCESS(proc_drain,  "Stored Data TX");
+PROCESS(proc_cmd,    "Commands");
 
-AUTOSTART_PROCESSES(&proc_route, &proc_data, &proc_pick, &proc_stats);
+AUTOSTART_PROCESSES(&proc_route, &proc_data, &proc_pick, &proc_stats, &proc_drain,
+                    &proc_cmd);
 
 /*======================== Utilities ======================*/
 static void led_off_cb(void){ leds_off(LEDS_BLUE); }
 
+static int sink_index(unsigned short id){
+  for(int i=0;i<(int)NSINKS;i++) if(sink_ids[i]==id) return i;
+  return -1;
+}
+
+static int sink_alive(int s){
+  return sink_seq[s] != 0 && clock_seconds() - sink_heard[s] < SINK_TTL;
+}
+
+/* Hops to the nearest sink heard lately */
+static uint16_t sink_nearest_hops(void){
+  uint16_t best = UINT16_MAX;
+  for(int i=0;i<(int)NSINKS;i++) if(sink_alive(i) && sink_hops[i] < best) best = sink_hops[i];
+  return best;
+}
+
 static void nbr_init(void){
   for(int i=0;i<NBR_CAP;i++){
     nbrs[i].used = 0; nbrs[i].id = 0; nbrs[i].tx = nbrs[i].rx_ack = 0;
-    nbrs[i].rssi = -127; nbrs[i].hops_via = UINT16_MAX; nbrs[i].prr = 0.f; nbrs[i].seen_at = 0;
+    nbrs[i].rssi = -127; nbrs[i].hops_via = UINT16_MAX; nbrs[i].sink = 0;
+    nbrs[i].prr = 0.f; nbrs[i].seen_at = 0;
   }
 }
 
@@ -129,20 +261,28 @@ static int nbr_find(unsigned short id){
 
 static void nbr_touch(nbr_t *n){ n->used=1; n->seen_at = clock_time(); }
 
-static void nbr_upsert(unsigned short id, int rssi, uint16_t hops){
+static void nbr_upsert(unsigned short id, int rssi, uint16_t hops,
+                       unsigned short sink){
   int k = nbr_find(id);
   if(k>=0){
-    nbrs[k].rssi = rssi; nbrs[k].hops_via = hops; nbr_touch(&nbrs[k]); return;
+    nbrs[k].rssi = rssi;
+    /* A neighbor may forward beacons of several sinks: keep the nearest,
+       unless the one it led to is gone */
+    int s = sink_index(nbrs[k].sink);
+    if(sink == nbrs[k].sink || hops < nbrs[k].hops_via || s < 0 || !sink_alive(s)){
+      nbrs[k].hops_via = hops; nbrs[k].sink = sink;
+    }
+    nbr_touch(&nbrs[k]); return;
   }
   for(int i=0;i<NBR_CAP;i++){
     if(!nbrs[i].used){
-      nbrs[i].id=id; nbrs[i].rssi=rssi; nbrs[i].hops_via=hops;
+      nbrs[i].id=id; nbrs[i].rssi=rssi; nbrs[i].hops_via=hops; nbrs[i].sink=sink;
       nbrs[i].tx=nbrs[i].rx_ack=0; nbrs[i].prr=0.f; nbr_touch(&nbrs[i]); return;
     }
   }
 
   int oldest=0; for(int i=1;i<NBR_CAP;i++) if(nbrs[i].seen_at<nbrs[oldest].seen_at) oldest=i;
-  nbrs[oldest].id=id; nbrs[oldest].rssi=rssi; nbrs[oldest].hops_via=hops;
+  nbrs[oldest].id=id; nbrs[oldest].rssi=rssi; nbrs[oldest].hops_via=hops; nbrs[oldest].sink=sink;
   nbrs[oldest].tx=nbrs[oldest].rx_ack=0; nbrs[oldest].prr=0.f; nbr_touch(&nbrs[oldest]);
 }
 
@@ -151,7 +291,7 @@ static void nbr_expire(void){
   for(int i=0;i<NBR_CAP;i++){
     if(nbrs[i].used && (now - nbrs[i].seen_at > NBR_TTL)){
       if(nbrs[i].id == next_hop){
-        printf("[aging] parent %u expired; reset\n", next_hop);
+        BINLOG("[aging] parent %u expired; reset\n", next_hop);
         next_hop = 0;
       }
       nbrs[i].used = 0;
@@ -171,16 +311,13 @@ static void parent_set(unsigned short id){
     next_hop = id;
     int k = nbr_find(id);
     int prr_i = (k>=0) ? (int)(nbrs[k].prr*100.f) : -1;
-    printf("[route] parent=%u (hop=%u rssi=%d prr=%d%%)\n",
+    BINLOG("[route] parent=%u (hop=%u rssi=%d prr=%d%%)\n",
            next_hop, (k>=0?nbrs[k].hops_via:0), (k>=0?nbrs[k].rssi:0), prr_i);
   }
 }
 
-static void temp_print(uint16_t raw){
-  printf("%d.%d", (raw / 10 - 396) / 10, (raw / 10 - 396) % 10);
-}
-
 static void data_send(data_msg_t *m){
+  if(m->src == node_id) m->parent = next_hop;
   packetbuf_clear();
   packetbuf_copyfrom(m, sizeof(*m));
   linkaddr_t nh; nh.u8[0]=next_hop; nh.u8[1]=0;
@@ -188,34 +325,152 @@ static void data_send(data_msg_t *m){
   prr_bump(next_hop, 0); 
 }
 
+/* No parent: keep the data for proc_drain */
+static void data_store(data_msg_t *m){
+  int ev = flash_queue_push(&sfq, m);
+  if(ev > 0) BINLOG("[sf] evict n=%d\n", ev);
+  BINLOG("[sf] store src=%u id=%u queued=%u ok=%d\n",
+         m->src, m->data_id, flash_queue_len(&sfq), ev >= 0);
+}
+
+static void tbl_print(void){
+  BINLOG("[tbl] node=%u parent=%u policy=%d\n", node_id, next_hop, PICK_POLICY);
+  BINLOG(" id  hop rssi tx ack prr%%\n");
+  for(int i=0;i<NBR_CAP;i++){
+    if(!nbrs[i].used || nbrs[i].hops_via==UINT16_MAX) continue;
+    int prr_i = (int)( (nbrs[i].tx? (nbrs[i].prr*100.f) : 0) );
+    BINLOG(" %-3u %-3u %-4d %-3u %-3u %3d\n",
+           nbrs[i].id, nbrs[i].hops_via, nbrs[i].rssi, nbrs[i].tx, nbrs[i].rx_ack, prr_i);
+  }
+}
+
+/*===================== Source Routes =====================*/
+static int route_find(unsigned short id){
+  for(int i=0;i<ROUTE_CAP;i++) if(routes[i].id==id) return i;
+  return -1;
+}
+
+/* Sink: id sent data through parent */
+static void route_learn(unsigned short id, unsigned short parent){
+  if(!parent) return;
+  int k = route_find(id);
+  if(k<0){
+    /* a free entry, else the oldest */
+    k=0;
+    for(int i=0;i<ROUTE_CAP;i++){
+      if(!routes[i].id){ k=i; break; }
+      if(routes[i].seen_at<routes[k].seen_at) k=i;
+    }
+  }
+  routes[k].id = id; routes[k].parent = parent; routes[k].seen_at = clock_time();
+}
+
+/* Path from this sink to dst, first hop first, by following the parents
+   up from dst. 0 if a parent is not known or the path is too long. */
+static uint8_t route_build(unsigned short dst, unsigned short *route){
+  uint8_t n=0;
+  for(unsigned short id=dst; id!=node_id; ){
+    int k = route_find(id);
+    if(n==CMD_ROUTE_MAX || k<0 || clock_time() - routes[k].seen_at > ROUTE_TTL) return 0;
+    route[n++] = id;
+    id = routes[k].parent;
+  }
+  for(uint8_t i=0;i<n/2;i++){
+    unsigned short t=route[i]; route[i]=route[n-1-i]; route[n-1-i]=t;
+  }
+  return n;
+}
+
+/*======================== Commands =======================*/
+static void cmd_unicast(const cmd_msg_t *m){
+  packetbuf_clear();
+  packetbuf_copyfrom(m, CMD_SIZE(m));
+  linkaddr_t nh; nh.u8[0]=m->route[m->pos]; nh.u8[1]=0;
+  unicast_send(&uc_cmd, &nh);
+}
+
+static void cmd_flood(void *p){
+  cmd_msg_t *m = p;
+  packetbuf_clear();
+  packetbuf_copyfrom(m, CMD_SIZE(m));
+  broadcast_send(&bc_cmd);
+  BINLOG("[cmd] flood seq=%u origin=%u hop=%u\n", m->cmd_seq, m->origin, m->pos);
+}
+
+static void cmd_exec(const cmd_msg_t *m){
+  BINLOG("[cmd] exec seq=%u origin=%u type=%u arg=%u hops=%u\n",
+         m->cmd_seq, m->origin, m->type, m->arg, m->pos + 1);
+  switch(m->type){
+  case CMD_T_DATA:
+    if(m->arg > 0 && m->arg <= T_DATA_MAX){ t_data = m->arg; process_poll(&proc_data); }
+    break;
+  case CMD_DUMP:
+    tbl_print();
+    break;
+  }
+}
+
+/* Sink: send a command to dst, along its path if known */
+static void cmd_send(unsigned short dst, uint8_t type, uint16_t arg){
+  cmd_msg_t m;
+  memset(&m, 0, sizeof(m));
+  m.origin = node_id; m.cmd_seq = ++cmd_seq_tx; m.arg = arg; m.type = type; m.dst = dst;
+#if !CMD_FLOOD
+  m.len = route_build(dst, m.route);
+#endif
+  BINLOG("[cmd] send seq=%u dst=%u type=%u arg=%u route=%u\n",
+         m.cmd_seq, dst, type, arg, m.len);
+  if(m.len) cmd_unicast(&m);
+  else cmd_flood(&m);
+}
+
+/* Sink: "cmd <node> ping|dump|tdata <s>" from the serial line */
+static void cmd_parse(char *line){
+  char *p;
+  if(strncmp(line, "cmd ", 4)) return;
+  unsigned short dst = (unsigned short)strtoul(line + 4, &p, 10);
+  while(*p == ' ') p++;
+  if(!dst) return;
+  if(!strncmp(p, "ping", 4)) cmd_send(dst, CMD_PING, 0);
+  else if(!strncmp(p, "dump", 4)) cmd_send(dst, CMD_DUMP, 0);
+  else if(!strncmp(p, "tdata ", 6)) cmd_send(dst, CMD_T_DATA, (uint16_t)strtoul(p + 6, NULL, 10));
+}
+
 /*======================== Callbacks ======================*/
 static void cb_bc(struct broadcast_conn *c, linkaddr_t *from){
-  if(node_id == SINK_ID) return;
+  if(is_sink) return;
 
   beacon_msg_t b; packetbuf_copyto(&b);
+  int s = sink_index(b.adv_sink);
+  if(s < 0) return;
   /* grab RSSI attr */
   NETSTACK_RADIO.get_value(RADIO_PARAM_CHANNEL, &rtmp);
   rtmp = packetbuf_attr(PACKETBUF_ATTR_RSSI);
   int rssi = (int8_t)rtmp;
 
-  printf("[beacon] from=%u seq=%u hop=%u rssi=%d\n",
-         from->u8[0], b.adv_seq, b.adv_hops, rssi);
+  BINLOG("[beacon] from=%u seq=%u hop=%u rssi=%d sink=%u\n",
+         from->u8[0], b.adv_seq, b.adv_hops, rssi, b.adv_sink);
 
   /* record advertiser as candidate */
-  nbr_upsert(b.adv_parent, rssi, b.adv_hops);
+  nbr_upsert(b.adv_parent, rssi, b.adv_hops, b.adv_sink);
 
-  static uint16_t prev = 0;
+  /* Each sink's beacons are flooded once per sequence number, and only
+     as far as that sink is the nearest: beyond, nodes join another */
   uint8_t fwd = 0;
-  if(prev==0){                 
-    parent_set(b.adv_parent); fwd=1;
-  } else if(b.adv_seq > prev){ fwd=1; }
-  prev = b.adv_seq;
+  if(sink_seq[s]==0){
+    if(!next_hop) parent_set(b.adv_parent);
+    fwd=1;
+  } else if(b.adv_seq > sink_seq[s]){ fwd=1; }
+  if(fwd || b.adv_hops < sink_hops[s]) sink_hops[s] = b.adv_hops;
+  sink_seq[s] = b.adv_seq;
+  sink_heard[s] = clock_seconds();
+  if(fwd && sink_hops[s] > sink_nearest_hops()) fwd = 0;
 
   if(fwd){
-    beacon_msg_t out = { node_id, (uint16_t)(b.adv_hops+1), b.adv_seq };
+    beacon_msg_t out = { node_id, (uint16_t)(b.adv_hops+1), b.adv_seq, b.adv_sink };
     packetbuf_copyfrom(&out, sizeof(out));
     broadcast_send(&bc);
-    printf("[beacon] fwd seq=%u newhop=%u\n", out.adv_seq, out.adv_hops);
+    BINLOG("[beacon] fwd seq=%u newhop=%u\n", out.adv_seq, out.adv_hops);
   }
 }
 
@@ -231,24 +486,57 @@ static void cb_uc_data(struct unicast_conn *c, const linkaddr_t *from){
   int k = nbr_find(from->u8[0]);
   if(k>=0) nbr_touch(&nbrs[k]);
 
-  if(node_id == SINK_ID){
+  if(is_sink){
+    /* Any sink takes the data, whichever the sender joined */
     if(d.hops < HOPS_MAX) hop_hist[d.hops]++;
-    printf("[sink] recv src=%u hops=%u temp=", d.src, d.hops);
-    temp_print(d.temp_raw);
-    printf("\n");
+    route_learn(d.src, d.parent);
+    int t = d.temp_raw / 10 - 396;
+    BINLOG("[sink] recv src=%u hops=%u temp=%d.%d\n", d.src, d.hops, t / 10, t % 10);
   }else{
     /* forward upwards */
     d.hops++;
-    data_send(&d);
-    printf("[relay] me=%u fwd src=%u -> parent=%u\n", node_id, d.src, next_hop);
+    if(!next_hop){ data_store(&d); return; }
+    data_send(&d); live_at = clock_time();
+    BINLOG("[relay] me=%u fwd src=%u -> parent=%u\n", node_id, d.src, next_hop);
   }
 }
 
+/* Copy a command frame; the route is as long as the frame */
+static int cmd_copy(cmd_msg_t *m){
+  uint16_t len = packetbuf_datalen();
+  memset(m, 0, sizeof(*m));
+  if(len < offsetof(cmd_msg_t, route)) return 0;
+  memcpy(m, packetbuf_dataptr(), len < sizeof(*m) ? len : sizeof(*m));
+  return m->len <= CMD_ROUTE_MAX && len >= CMD_SIZE(m);
+}
+
+static void cb_uc_cmd(struct unicast_conn *c, const linkaddr_t *from){
+  cmd_msg_t m;
+  if(!cmd_copy(&m) || m.pos >= m.len || m.route[m.pos] != node_id) return;
+  if(m.pos == m.len - 1){ cmd_exec(&m); return; }
+  m.pos++;
+  cmd_unicast(&m);
+  BINLOG("[cmd] fwd seq=%u origin=%u -> %u\n", m.cmd_seq, m.origin, m.route[m.pos]);
+}
+
+static void cb_bc_cmd(struct broadcast_conn *c, const linkaddr_t *from){
+  cmd_msg_t m;
+  if(is_sink || !cmd_copy(&m)) return;
+  int s = sink_index(m.origin);
+  if(s < 0 || (cmd_seen[s] && (int16_t)(m.cmd_seq - cmd_seen[s]) <= 0)) return;
+  cmd_seen[s] = m.cmd_seq;
+  if(m.dst == node_id){ cmd_exec(&m); return; }
+  /* Repeat once, a little later than the neighbors that heard it too */
+  m.pos++;
+  cmd_pending = m;
+  ctimer_set(&cmd_jitter, 1 + random_rand() % (CLOCK_SECOND / 8), cmd_flood, &cmd_pending);
+}
+
 static void cb_uc_ack(struct unicast_conn *c, const linkaddr_t *from){
   ack_msg_t a; packetbuf_copyto(&a);
   prr_bump(from->u8[0], 1);
   int k = nbr_find(from->u8[0]); if(k>=0) nbr_touch(&nbrs[k]);
-  printf("[ack] from=%u data=%u\n", from->u8[0], a.data_id);
+  BINLOG("[ack] from=%u data=%u\n", from->u8[0], a.data_id);
 }
 
 /*======================= Selection =======================*/
@@ -261,6 +549,14 @@ static inline float score_prr (const nbr_t *n){
   return (n->tx < PRR_MIN_SAMPLES) ? -1.f : n->prr;
 }
 
+/* Of two neighbors equally good, nodes prefer the one leading to
+   their own sink of the list, to split the load between sinks that
+   are as near */
+static int better_tie(const nbr_t *n, const nbr_t *best){
+  unsigned short mine = sink_ids[node_id % NSINKS];
+  return n->sink == mine && best->sink != mine;
+}
+
 static void parent_reselect(void){
   nbr_t *best=NULL; float s_best=-1.f;
 
@@ -278,8 +574,9 @@ static void parent_reselect(void){
     if(s > s_best){ best=&nbrs[i]; s_best=s; }
     else if(s == s_best && best){
       if(nbrs[i].hops_via < best->hops_via) best=&nbrs[i];
-      else if(nbrs[i].hops_via == best->hops_via && nbrs[i].rssi > best->rssi) best=&nbrs[i];
-      else if(nbrs[i].hops_via == best->hops_via && nbrs[i].rssi == best->rssi && nbrs[i].id < best->id) best=&nbrs[i];
+      else if(nbrs[i].hops_via == best->hops_via && better_tie(&nbrs[i], best)) best=&nbrs[i];
+      else if(nbrs[i].hops_via == best->hops_via && nbrs[i].sink == best->sink && nbrs[i].rssi > best->rssi) best=&nbrs[i];
+      else if(nbrs[i].hops_via == best->hops_via && nbrs[i].sink == best->sink && nbrs[i].rssi == best->rssi && nbrs[i].id < best->id) best=&nbrs[i];
     }
   }
 
@@ -292,7 +589,8 @@ static void parent_reselect(void){
       if(s > s_best){ best=&nbrs[i]; s_best=s; }
       else if(s == s_best && best){
         if(nbrs[i].hops_via < best->hops_via) best=&nbrs[i];
-        else if(nbrs[i].hops_via == best->hops_via && nbrs[i].rssi > best->rssi) best=&nbrs[i];
+        else if(nbrs[i].hops_via == best->hops_via && better_tie(&nbrs[i], best)) best=&nbrs[i];
+        else if(nbrs[i].hops_via == best->hops_via && nbrs[i].sink == best->sink && nbrs[i].rssi > best->rssi) best=&nbrs[i];
       }
     }
   }
@@ -305,31 +603,36 @@ static void parent_reselect(void){
 static const struct broadcast_callbacks bc_cb = { cb_bc };
 static const struct unicast_callbacks  uc_data_cb = { cb_uc_data };
 static const struct unicast_callbacks  uc_ack_cb  = { cb_uc_ack };
+static const struct unicast_callbacks  uc_cmd_cb  = { cb_uc_cmd };
+static const struct broadcast_callbacks bc_cmd_cb = { cb_bc_cmd };
 
 PROCESS_THREAD(proc_route, ev, data){
   PROCESS_EXITHANDLER(broadcast_close(&bc);)
   PROCESS_BEGIN();
 
+  stack_probe_start(60 * CLOCK_SECOND);
   broadcast_open(&bc, CH_BC, &bc_cb);
   memset(hop_hist, 0, sizeof(hop_hist));
   nbr_init();
   next_hop = 0; disc_seq_rx = 0;
+  is_sink = sink_index(node_id) >= 0;
 
-  if(node_id == SINK_ID){
-    /* sink emits beacons forever */
+  if(is_sink){
+    /* sinks emit beacons forever */
     etimer_set(&et0, T_STARTUP_WAIT * CLOCK_SECOND);
     PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et0));
 
+    slack_timer_set(&st0, (clock_time_t)T_BC * CLOCK_SECOND, SLACK(T_BC));
     while(1){
-      beacon_msg_t b = { SINK_ID, 1, ++disc_seq_tx };
+      beacon_msg_t b = { node_id, 1, ++disc_seq_tx, node_id };
       packetbuf_copyfrom(&b, sizeof(b));
       broadcast_send(&bc);
 
       leds_on(LEDS_BLUE);
       ctimer_set(&led_off, CLOCK_SECOND/8, led_off_cb, NULL);
 
-      etimer_set(&et0, T_BC * CLOCK_SECOND);
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et0));
+      PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st0));
+      slack_timer_reset(&st0);
     }
   }else{
     while(1) PROCESS_WAIT_EVENT();
@@ -347,18 +650,28 @@ PROCESS_THREAD(proc_data, ev, data){
   SENSORS_ACTIVATE(sht11_sensor);
 
   /* small desync based on id */
-  etimer_set(&et1, (node_id % T_DATA) * CLOCK_SECOND);
-  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et1));
+  slack_timer_set(&st1, (node_id % T_DATA) * CLOCK_SECOND, SLACK(T_DATA));
+  PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st1));
 
+  slack_timer_set(&st1, t_data * CLOCK_SECOND, SLACK(t_data));
   while(1){
-    etimer_set(&et1, T_DATA * CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et1));
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || slack_timer_expired(&st1));
+    if(ev == PROCESS_EVENT_POLL){
+      /* new period from a command */
+      slack_timer_set(&st1, t_data * CLOCK_SECOND, SLACK(t_data));
+      continue;
+    }
+    slack_timer_reset(&st1);
 
-    if(node_id != SINK_ID && next_hop){
+    if(!is_sink){
       data_msg_t d = { node_id, 1, sht11_sensor.value(SHT11_SENSOR_TEMP), ++data_seq };
-      data_send(&d);
-      printf("[tx] node=%u -> %u id=%u\n", node_id, next_hop, data_seq);
-    }else if(node_id == SINK_ID){
+      if(next_hop){
+        data_send(&d); live_at = clock_time();
+        BINLOG("[tx] node=%u -> %u id=%u\n", node_id, next_hop, data_seq);
+      }else{
+        data_store(&d);
+      }
+    }else{
       hop_hist[0]++; 
     }
   }
@@ -368,32 +681,106 @@ PROCESS_THREAD(proc_data, ev, data){
 
 PROCESS_THREAD(proc_pick, ev, data){
   PROCESS_BEGIN();
+  slack_timer_set(&st2, T_RESELECT * CLOCK_SECOND, SLACK(T_RESELECT));
   while(1){
-    etimer_set(&et2, T_RESELECT * CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et2));
+    PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st2));
+    slack_timer_reset(&st2);
     nbr_expire();
-    if(node_id != SINK_ID) parent_reselect();
+    if(!is_sink) parent_reselect();
   }
   PROCESS_END();
 }
 
 PROCESS_THREAD(proc_stats, ev, data){
   PROCESS_BEGIN();
+  slack_timer_set(&st3, T_PRINT * CLOCK_SECOND, SLACK(T_PRINT));
   while(1){
-    etimer_set(&et3, T_PRINT * CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et3));
-    if(node_id == SINK_ID){
-      printf("[hops] "); for(int i=0;i<HOPS_MAX;i++) printf("%d ", hop_hist[i]); printf("\n");
+    PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st3));
+    slack_timer_reset(&st3);
+    /* CPU and low power mode time since boot, in rtimer ticks */
+    energest_flush();
+    BINLOG("[energest] cpu=%lu lpm=%lu\n",
+           energest_type_time(ENERGEST_TYPE_CPU), energest_type_time(ENERGEST_TYPE_LPM));
+    if(is_sink){
+      /* In parts, BINLOG takes at most 10 values */
+      const short *h = hop_hist;
+      BINLOG("[hops] sink=%u %d %d %d %d %d %d %d %d %d ", node_id,
+             h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], h[8]);
+      BINLOG("%d %d %d %d %d %d %d %d %d %d ",
+             h[9], h[10], h[11], h[12], h[13], h[14], h[15], h[16], h[17], h[18]);
+      BINLOG("%d \n", h[19]);
     }else{
-      printf("[tbl] node=%u parent=%u policy=%d\n", node_id, next_hop, PICK_POLICY);
-      printf(" id  hop rssi tx ack prr%%\n");
-      for(int i=0;i<NBR_CAP;i++){
-        if(!nbrs[i].used || nbrs[i].hops_via==UINT16_MAX) continue;
-        int prr_i = (int)( (nbrs[i].tx? (nbrs[i].prr*100.f) : 0) );
-        printf(" %-3u %-3u %-4d %-3u %-3u %3d\n",
-               nbrs[i].id, nbrs[i].hops_via, nbrs[i].rssi, nbrs[i].tx, nbrs[i].rx_ack, prr_i);
+      tbl_print();
+    }
+  }
+  PROCESS_END();
+}
+
+PROCESS_THREAD(proc_drain, ev, data){
+  static struct etimer gap;
+  static uint8_t n;
+  PROCESS_BEGIN();
+
+  flash_queue_init(&sfq, "sfq", sizeof(data_msg_t), SF_SEG_RECS, SF_SEGMENTS);
+
+  slack_timer_set(&st4, T_DRAIN * CLOCK_SECOND, SLACK(T_DRAIN));
+  while(1){
+    PROCESS_WAIT_EVENT_UNTIL(slack_timer_expired(&st4));
+    slack_timer_reset(&st4);
+
+    for(n = 0; n < SF_BATCH && next_hop && flash_queue_len(&sfq) > 0; n++){
+      /* live data goes first */
+      while(clock_time() - live_at < SF_GAP){
+        etimer_set(&gap, SF_GAP);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&gap));
+      }
+      if(!next_hop) break;
+
+      data_msg_t d;
+      if(!flash_queue_peek(&sfq, &d)){ flash_queue_pop(&sfq); continue; }
+      flash_queue_pop(&sfq);
+      data_send(&d);
+      BINLOG("[sf] drain src=%u id=%u -> %u queued=%u\n",
+             d.src, d.data_id, next_hop, flash_queue_len(&sfq));
+
+      etimer_set(&gap, SF_GAP);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&gap));
+    }
+  }
+  PROCESS_END();
+}
+
+PROCESS_THREAD(proc_cmd, ev, data){
+#if T_CMD
+  static uint8_t next;
+#endif
+  PROCESS_BEGIN();
+
+  unicast_open(&uc_cmd, CH_CMD, &uc_cmd_cb);
+  broadcast_open(&bc_cmd, CH_CMD_FLOOD, &bc_cmd_cb);
+  if(!is_sink){
+    while(1) PROCESS_WAIT_EVENT();
+  }
+
+  serial_line_init();
+#if T_CMD
+  slack_timer_set(&st5, T_CMD * CLOCK_SECOND, SLACK(T_CMD));
+#endif
+  while(1){
+    PROCESS_WAIT_EVENT();
+    if(ev == serial_line_event_message && data != NULL){
+      cmd_parse((char *)data);
+    }
+#if T_CMD
+    if(ev == PROCESS_EVENT_TIMER && data == &st5.et){
+      slack_timer_reset(&st5);
+      /* the next node this sink has heard from */
+      for(uint8_t i=0;i<ROUTE_CAP;i++){
+        next = (next + 1) % ROUTE_CAP;
+        if(routes[next].id){ cmd_send(routes[next].id, CMD_PING, 0); break; }
       }
     }
+#endif
   }
   PROCESS_END();
 }
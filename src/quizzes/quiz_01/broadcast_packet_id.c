@@ -5,28 +5,155 @@
 #include <stdio.h>
 #include <string.h>
 
+/* Number of payload bytes sent after the header, 0 for header only */
+#ifndef PAYLOAD_LEN
+#define PAYLOAD_LEN 0
+#endif
+
+/* Number of senders the receiver keeps statistics for */
+#define MAX_SENDERS 8
+
+/* Ids this far below the highest one seen are still told apart as late
+   (reordered) or duplicate; anything older is counted as stale */
+#define WINDOW 32
+
+#define HDR_VERSION 1
+
+/*
+ * Fixed binary header at the start of every broadcast. All motes run the
+ * same code, so fields are in the sender's native byte order. Laid out
+ * without padding: 12 bytes on msp430 and on the native target.
+ */
+struct packet_hdr {
+  uint8_t version;
+  uint8_t payload_len;
+  linkaddr_t sender;
+  uint32_t id;
+  uint32_t timestamp;     /* clock_time() of the sender when sent */
+};
+
+/* Per-sender reception statistics */
+struct sender_stats {
+  linkaddr_t addr;
+  uint32_t highest;       /* highest id received */
+  uint32_t window;        /* bit n set: id highest - n was received */
+  uint32_t received, lost, reordered, duplicates, stale;
+  uint32_t last_tx;       /* sender timestamp and local time of the */
+  clock_time_t last_rx;   /* newest packet, for the jitter estimate */
+  uint16_t jitter;        /* interarrival jitter in clock ticks, x16 */
+};
+
+static struct sender_stats senders[MAX_SENDERS];
+static uint16_t malformed;
+
 /* Process to handle broadcasting packets with an increasing packet ID */
 PROCESS(example_broadcast_process, "Broadcast Example with Packet ID");
 AUTOSTART_PROCESSES(&example_broadcast_process);
 
+/*---------------------------------------------------------------------------*/
+/* Statistics entry of a sender, taking the least active slot for a new
+   one when the table is full */
+static struct sender_stats *
+lookup_sender(const linkaddr_t *addr)
+{
+  struct sender_stats *s, *victim = &senders[0];
+
+  for(s = senders; s < &senders[MAX_SENDERS]; s++) {
+    if(s->received > 0 && linkaddr_cmp(&s->addr, addr)) {
+      return s;
+    }
+    if(s->received < victim->received) {
+      victim = s;
+    }
+  }
+  memset(victim, 0, sizeof(*victim));
+  linkaddr_copy(&victim->addr, addr);
+  return victim;
+}
+/*---------------------------------------------------------------------------*/
+/* Account for packet id from sender s */
+static void
+update_stats(struct sender_stats *s, const struct packet_hdr *hdr)
+{
+  uint32_t id = hdr->id, back;
+  clock_time_t now = clock_time();
+  int32_t d;
+
+  if(s->received == 0 || (id == 1 && s->highest > WINDOW)) {
+    /* First packet, or the sender restarted counting. Older ids were
+       sent before we listened: treat them as seen, not as late. */
+    s->highest = id;
+    s->window = 0xffffffffUL;
+  } else if(id > s->highest) {
+    /* New packet, the ids jumped over were lost (so far) */
+    back = id - s->highest;
+    s->lost += back - 1;
+    s->window = back < WINDOW ? (s->window << back) | 1 : 1;
+    s->highest = id;
+
+    /* RFC 3550 style jitter: the change in transit time between
+       consecutive packets, smoothed over 16 packets. Both intervals
+       are taken in clock_time_t, which wraps (every 512 s on Sky). */
+    d = (int32_t)(clock_time_t)(now - s->last_rx) -
+        (int32_t)(clock_time_t)(hdr->timestamp - s->last_tx);
+    if(d < 0) {
+      d = -d;
+    }
+    if(d > 0xfff) {
+      d = 0xfff;
+    }
+    s->jitter += d - ((s->jitter + 8) >> 4);
+  } else {
+    back = s->highest - id;
+    if(back >= WINDOW) {
+      s->stale++;
+      return;
+    }
+    if(s->window & (1UL << back)) {
+      s->duplicates++;
+      return;
+    }
+    /* Late packet that was counted as lost */
+    s->window |= 1UL << back;
+    s->reordered++;
+    s->lost--;
+    s->received++;
+    return;
+  }
+  s->received++;
+  s->last_tx = hdr->timestamp;
+  s->last_rx = now;
+}
+/*---------------------------------------------------------------------------*/
 /* Callback function executed when a broadcast packet is received */
 static void
 broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from)
 {
-  char *msg = (char *)packetbuf_dataptr();  
-  int recv_id = -1;
+  struct packet_hdr hdr;
+  struct sender_stats *s;
 
-  /* Extract packet_id from the received message */
-    char *underscore = strchr(msg, '_');
-    if (underscore != NULL) {
-      recv_id = atoi(underscore + 1);
-    }
+  /* Copy out the header: the packet buffer may not be aligned */
+  if(packetbuf_datalen() < sizeof(hdr)) {
+    malformed++;
+    return;
+  }
+  memcpy(&hdr, packetbuf_dataptr(), sizeof(hdr));
+  if(hdr.version != HDR_VERSION ||
+     packetbuf_datalen() != sizeof(hdr) + hdr.payload_len) {
+    malformed++;
+    return;
+  }
+
+  s = lookup_sender(&hdr.sender);
+  update_stats(s, &hdr);
 
   /* Print the information about the received packet */
-  printf("Received packet ID = %d from node %d.%d payload = \"%s\"\n",
-         recv_id,
-         from->u8[0], from->u8[1],
-         msg);
+  printf("Received packet ID = %lu from node %d.%d: rx %lu lost %lu "
+         "reordered %lu dup %lu stale %lu jitter %u malformed %u\n",
+         (unsigned long)hdr.id, from->u8[0], from->u8[1],
+         (unsigned long)s->received, (unsigned long)s->lost,
+         (unsigned long)s->reordered, (unsigned long)s->duplicates,
+         (unsigned long)s->stale, s->jitter >> 4, malformed);
 }
 
 /* Structure holding the broadcast callback */
@@ -36,34 +163,43 @@ static struct broadcast_conn broadcast;
 
 PROCESS_THREAD(example_broadcast_process, ev, data)
 {
-  static struct etimer et;       
-  static char msg[32];          
-  static int packet_id = 1;      
+  static struct etimer et;
+  static struct packet_hdr hdr;
+  static uint32_t packet_id = 1;
+  uint8_t *buf;
 
-  PROCESS_EXITHANDLER(broadcast_close(&broadcast);) 
+  PROCESS_EXITHANDLER(broadcast_close(&broadcast);)
 
   PROCESS_BEGIN();
 
   /* Open broadcast connection on channel 129 and set the receive callback */
   broadcast_open(&broadcast, 129, &broadcast_call);
 
+  hdr.version = HDR_VERSION;
+  hdr.payload_len = PAYLOAD_LEN;
+  linkaddr_copy(&hdr.sender, &linkaddr_node_addr);
+
   while(1) {
     /* Set the timer to 10 seconds */
     etimer_set(&et, CLOCK_SECOND * 10);
     PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
 
-    /* Create the payload with the current packet ID */
-    snprintf(msg, sizeof(msg), "hello packet_%d", packet_id++);
-
-    /* Copy payload to the packet buffer and send it via broadcast */
-    packetbuf_copyfrom(msg, strlen(msg) + 1);
+    /* Build the header, followed by the optional payload */
+    hdr.id = packet_id++;
+    hdr.timestamp = clock_time();
+    packetbuf_clear();
+    buf = packetbuf_dataptr();
+    memcpy(buf, &hdr, sizeof(hdr));
+    memset(buf + sizeof(hdr), 0xa5, PAYLOAD_LEN);
+    packetbuf_set_datalen(sizeof(hdr) + PAYLOAD_LEN);
     broadcast_send(&broadcast);
 
     /* Print log about the sent packet */
-    printf("Node %d.%d sent: \"%s\"\n",
+    printf("Node %d.%d sent packet ID = %lu (%u bytes)\n",
            linkaddr_node_addr.u8[0],
            linkaddr_node_addr.u8[1],
-           msg);
+           (unsigned long)hdr.id,
+           (unsigned)(sizeof(hdr) + PAYLOAD_LEN));
   }
 
   PROCESS_END();
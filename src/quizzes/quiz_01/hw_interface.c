@@ -1,61 +1,301 @@
 #include "contiki.h"
-#include "dev/button-sensor.h"
 #include "dev/leds.h"
 #include "dev/serial-line.h"
+#include "button-events.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/*
+ * Serial command shell. A line holds one or more commands separated by
+ * ';' and gets one reply line with one result per command in the same
+ * order, also separated by ';' (results that do not fit in REPLY_SIZE
+ * continue on further lines). For example
+ *
+ *   ON RED;TOGGLE GREEN;STATUS    ->    ok;ok;L=3 B=0
+ *
+ * Commands (LED is RED, GREEN, BLUE or ALL):
+ *   ON LED, OFF LED, TOGGLE LED
+ *   BLINK LED [count] [period ms]   toggle LED count times (default 3, 250 ms,
+ *                                   at most 60 s)
+ *   STOP                            stop blinking
+ *   STATUS                          L=<LED bits, hex> B=<toggles left>
+ *   UPTIME                          T=<seconds since boot>
+ *   PING                            ok
+ * Unknown commands or bad arguments answer "E".
+ *
+ * Button: click toggles the green LED, double click the blue one, a
+ * long press turns all LEDs off and stops blinking.
+ */
+
+#define REPLY_SIZE 64
+
+/* Longest blink period accepted, in ms; longer ones are cut to it */
+#define BLINK_PERIOD_MAX 60000UL
+
 PROCESS(hw_interface_process, "HW Interface Example");
 AUTOSTART_PROCESSES(&hw_interface_process);
 
+/* LED names accepted by the commands */
+static const struct {
+  const char *name;
+  unsigned char mask;
+} led_names[] = {
+  { "RED", LEDS_RED },
+  { "GREEN", LEDS_GREEN },
+  { "BLUE", LEDS_BLUE },
+  { "ALL", LEDS_ALL },
+};
+
+/* Blink state, driven by a callback timer so blinking does not hold up
+   the serial commands */
+static struct ctimer blink_timer;
+static unsigned char blink_mask;
+static unsigned int blink_left;
+static clock_time_t blink_period;
+
+/*---------------------------------------------------------------------------*/
+static void
+blink_step(void *ptr)
+{
+  leds_toggle(blink_mask);
+  if(--blink_left > 0) {
+    ctimer_reset(&blink_timer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Mask of the LED named by arg, 0 if there is no such LED */
+static unsigned char
+led_mask(const char *arg)
+{
+  int i;
+
+  for(i = 0; i < sizeof(led_names) / sizeof(led_names[0]); i++) {
+    if(arg != NULL && strcmp(arg, led_names[i].name) == 0) {
+      return led_names[i].mask;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Command handlers get the words after the command name (NULL if absent)
+   and write their result to reply; they return 0 on bad arguments */
+static int
+cmd_on(char *arg, char *arg2, char *reply)
+{
+  unsigned char mask = led_mask(arg);
+
+  leds_on(mask);
+  return mask != 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_off(char *arg, char *arg2, char *reply)
+{
+  unsigned char mask = led_mask(arg);
+
+  leds_off(mask);
+  return mask != 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_toggle(char *arg, char *arg2, char *reply)
+{
+  unsigned char mask = led_mask(arg);
+
+  leds_toggle(mask);
+  return mask != 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_blink(char *arg, char *arg2, char *reply)
+{
+  unsigned char mask = led_mask(arg);
+  char *period = NULL, *end;
+  unsigned long ms = 250;
+  int count = 3;
+
+  if(mask == 0) {
+    return 0;
+  }
+  if(arg2 != NULL) {
+    /* "count" or "count period" */
+    period = strchr(arg2, ' ');
+    if(period != NULL) {
+      *period++ = '\0';
+    }
+    count = atoi(arg2);
+  }
+  if(period != NULL) {
+    ms = strtoul(period, &end, 10);
+    if(end == period || *end != '\0' || ms == 0) {
+      return 0;
+    }
+    if(ms > BLINK_PERIOD_MAX) {
+      ms = BLINK_PERIOD_MAX;
+    }
+  }
+  blink_mask = mask;
+  blink_left = count > 0 ? count : 1;
+  /* In unsigned long: ms * CLOCK_SECOND overflows an int on msp430 */
+  blink_period = (clock_time_t)(ms * CLOCK_SECOND / 1000);
+  if(blink_period == 0) {
+    blink_period = 1;
+  }
+  ctimer_set(&blink_timer, blink_period, blink_step, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_stop(char *arg, char *arg2, char *reply)
+{
+  ctimer_stop(&blink_timer);
+  blink_left = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_status(char *arg, char *arg2, char *reply)
+{
+  sprintf(reply, "L=%x B=%u", leds_get(), blink_left);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_uptime(char *arg, char *arg2, char *reply)
+{
+  sprintf(reply, "T=%lu", (unsigned long)clock_seconds());
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmd_ping(char *arg, char *arg2, char *reply)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The command table */
+static const struct {
+  const char *name;
+  int (*handler)(char *arg, char *arg2, char *reply);
+} commands[] = {
+  { "ON", cmd_on },
+  { "OFF", cmd_off },
+  { "TOGGLE", cmd_toggle },
+  { "BLINK", cmd_blink },
+  { "STOP", cmd_stop },
+  { "STATUS", cmd_status },
+  { "UPTIME", cmd_uptime },
+  { "PING", cmd_ping },
+};
+/*---------------------------------------------------------------------------*/
+/* Run one command and write its result to reply */
+static void
+run_command(char *cmd, char *reply)
+{
+  char *arg, *arg2;
+  int i;
+
+  /* Skip leading spaces, then split off the first two words */
+  while(*cmd == ' ') {
+    cmd++;
+  }
+  arg = strchr(cmd, ' ');
+  if(arg != NULL) {
+    *arg++ = '\0';
+  }
+  arg2 = arg != NULL ? strchr(arg, ' ') : NULL;
+  if(arg2 != NULL) {
+    *arg2++ = '\0';
+  }
+
+  strcpy(reply, "E");
+  for(i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+    if(strcmp(cmd, commands[i].name) == 0) {
+      strcpy(reply, "ok");
+      if(!commands[i].handler(arg, arg2, reply)) {
+        strcpy(reply, "E");
+      }
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(hw_interface_process, ev, data)
 {
-  static uint8_t green_led_state = 0; 
+  static uint8_t green_led_state = 0;
 
   PROCESS_BEGIN();
 
-  /* Activate button sensor and serial interface */
-  SENSORS_ACTIVATE(button_sensor);
+  /* Activate button events and serial interface */
+  button_events_init(&hw_interface_process);
   serial_line_init();
 
   while(1) {
     PROCESS_WAIT_EVENT();
 
-    /* Handle button press: turn ON GREEN LED */
-    if(ev == sensors_event && data == &button_sensor) {
-      green_led_state = !green_led_state;
+    /* Handle button: one event per interaction, already debounced */
+    if(ev == button_event) {
+      const struct button_event_info *b = data;
 
-      if(green_led_state) {
-        leds_on(LEDS_GREEN);
-        printf("Button pressed: GREEN LED ON\n");
-      } else {
-        leds_off(LEDS_GREEN);
-        printf("Button pressed: GREEN LED OFF\n");
+      if(b->type == BUTTON_EVENT_CLICK) {
+        green_led_state = !green_led_state;
+
+        if(green_led_state) {
+          leds_on(LEDS_GREEN);
+          printf("Button pressed: GREEN LED ON\n");
+        } else {
+          leds_off(LEDS_GREEN);
+          printf("Button pressed: GREEN LED OFF\n");
+        }
+      } else if(b->type == BUTTON_EVENT_DOUBLE_CLICK) {
+        leds_toggle(LEDS_BLUE);
+        printf("Button double click: BLUE LED toggled\n");
+      } else if(b->type == BUTTON_EVENT_LONG_PRESS) {
+        ctimer_stop(&blink_timer);
+        blink_left = 0;
+        leds_off(LEDS_ALL);
+        green_led_state = 0;
+        printf("Button long press: all LEDs OFF\n");
       }
     }
 
-    /* Handle serial commands */
+    /* Handle serial commands: run each ';' separated command and send
+       all results back in one line */
     if(ev == serial_line_event_message && data != NULL) {
-      char *input = (char *)data;
+      static char reply[REPLY_SIZE];
+      char result[16];
+      char *cmd = (char *)data;
+      char *next;
+      size_t len, rlen = 0;
 
       /* Remove newline or carriage return characters from the input */
-      size_t len = strlen(input);
-      if(len > 0 && (input[len-1] == '\n' || input[len-1] == '\r')) {
-        input[len-1] = '\0';
+      len = strlen(cmd);
+      if(len > 0 && (cmd[len-1] == '\n' || cmd[len-1] == '\r')) {
+        cmd[len-1] = '\0';
       }
 
-      /* Compare input command and execute LED actions */
-      if(strcmp(input, "ON RED") == 0) {
-        leds_on(LEDS_RED);
-        printf("Serial command: RED LED ON\n");
-      }
-      else if(strcmp(input, "OFF RED") == 0) {
-        leds_off(LEDS_RED);
-        printf("Serial command: RED LED OFF\n");
-      }
-      else {
-        printf("Unknown command: %s\n", input);
+      for(; cmd != NULL; cmd = next) {
+        next = strchr(cmd, ';');
+        if(next != NULL) {
+          *next++ = '\0';
+        }
+        run_command(cmd, result);
+        len = strlen(result);
+        if(rlen + len + 2 >= sizeof(reply)) {
+          /* Line full: send what we have and go on in a new one */
+          reply[rlen] = '\0';
+          printf("%s\n", reply);
+          rlen = 0;
+        }
+        if(rlen > 0) {
+          reply[rlen++] = ';';
+        }
+        memcpy(&reply[rlen], result, len);
+        rlen += len;
       }
+      reply[rlen] = '\0';
+      printf("%s\n", reply);
     }
   }
 
@@ -43,8 +43,10 @@
 #include "net/rpl/rpl.h"
 
 #include "net/netstack.h"
-#include "dev/button-sensor.h"
+#include "button-events.h"
 #include "dev/slip.h"
+#include "route-index.h"
+#include "stack-probe.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,8 +56,37 @@
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 
+/* The last prefix received from the host is saved in CFS (Coffee on
+ * Sky and Z1) so that after a reboot the DAG starts at once with it.
+ * The host is still asked for the prefix in the background, backing
+ * off exponentially, and a different answer restarts the DAG.
+ */
+#ifdef BORDER_ROUTER_CONF_SAVE_PREFIX
+#define SAVE_PREFIX BORDER_ROUTER_CONF_SAVE_PREFIX
+#elif CONTIKI_TARGET_SKY || CONTIKI_TARGET_Z1 || CONTIKI_TARGET_NATIVE
+#define SAVE_PREFIX 1
+#else
+#define SAVE_PREFIX 0
+#endif
+
+#ifdef BORDER_ROUTER_CONF_PREFIX_BACKOFF_MAX
+#define PREFIX_BACKOFF_MAX BORDER_ROUTER_CONF_PREFIX_BACKOFF_MAX
+#else
+#define PREFIX_BACKOFF_MAX (64 * CLOCK_SECOND)
+#endif
+
+#if SAVE_PREFIX
+#include "cfs/cfs.h"
+#define PREFIX_FILE  "prefix"
+#define PREFIX_MAGIC 0xa5
+#endif
+
 static uip_ipaddr_t prefix;
 static uint8_t prefix_set;
+/* Set once the host has sent the prefix since boot */
+static uint8_t prefix_confirmed;
+
+void slip_bridge_send(void);
 
 PROCESS(border_router_process, "Border router process");
 
@@ -68,8 +99,9 @@ AUTOSTART_PROCESSES(&border_router_process);
 AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 #else
 /* Use simple webserver with only one page for minimum footprint.
- * Multiple connections can result in interleaved tcp segments since
- * a single static buffer is used for all segments.
+ * Each connection formats its segments into its own buffer in
+ * struct httpd_state, so concurrent connections and tcp retransmissions
+ * do not garble each other's output.
  */
 #include "httpd-simple.h"
 /* The internal webserver can provide additional information if
@@ -78,15 +110,84 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 #define WEBSERVER_CONF_LOADTIME 0
 #define WEBSERVER_CONF_FILESTATS 0
 #define WEBSERVER_CONF_NEIGHBOR_STATUS 0
-/* Adding links requires a larger RAM buffer. To avoid static allocation
- * the stack can be used for formatting; however tcp retransmissions
- * and multiple connections can result in garbled segments.
- * TODO:use PSOCk_GENERATOR_SEND and tcp state storage to fix this.
+/* Adding links roughly doubles the length of a route line; the line is
+ * sent in two segments so the default output buffer still suffices.
  */
 #define WEBSERVER_CONF_ROUTE_LINKS 0
-#if WEBSERVER_CONF_ROUTE_LINKS
-#define BUF_USES_STACK 1
+/* Machine-readable, paged route and neighbor tables for monitoring:
+ *   /routes.json?o=<offset>&n=<limit>&g=<generation>
+ *   /nbrs.json?o=<offset>&n=<limit>
+ * If g matches the current route table generation only the generation
+ * and route count are returned, so pollers fetch only what changed.
+ */
+#define WEBSERVER_CONF_JSON 1
+#ifndef WEBSERVER_CONF_JSON_LIMIT
+#define WEBSERVER_CONF_JSON_LIMIT 16
+#endif
+/* Route additions and removals since a generation:
+ *   /changes.json?g=<generation>
+ * The last WEBSERVER_CONF_CHANGES of them are kept. An older g, or a
+ * change outside the DAG prefix, makes the reply carry "reset":1 and the
+ * client reloads routes.json. Lifetime refreshes are not changes.
+ */
+#ifndef WEBSERVER_CONF_CHANGES
+#define WEBSERVER_CONF_CHANGES 8
 #endif
+/* /dash.html, a self-contained page that loads routes.json once and
+ * then polls changes.json every few seconds. The page takes 755 bytes
+ * of flash, which the Sky does not have: its border router image left
+ * 912 of 49120 bytes free before the JSON replies were added. The Z1
+ * has about 5 kB to spare.
+ */
+#ifndef WEBSERVER_CONF_DASHBOARD
+#ifdef CONTIKI_TARGET_SKY
+#define WEBSERVER_CONF_DASHBOARD 0
+#else
+#define WEBSERVER_CONF_DASHBOARD 1
+#endif
+#endif
+
+#if WEBSERVER_CONF_JSON
+/* Bumped on every route addition or removal */
+static uint16_t routes_gen;
+static struct uip_ds6_notification route_notification;
+
+/* Change of generation g is at changes[g % WEBSERVER_CONF_CHANGES].
+   Only IIDs are kept: dst is in the DAG prefix, via is link-local. */
+#define CHANGE_ADD   1
+#define CHANGE_RM    2
+#define CHANGE_RESET 3          /* not representable, clients reload */
+static struct {
+  uint8_t op;
+  uint8_t dst[8];
+  uint8_t via[8];
+} changes[WEBSERVER_CONF_CHANGES];
+/*---------------------------------------------------------------------------*/
+static void
+route_callback(int event, uip_ipaddr_t *route, uip_ipaddr_t *nexthop,
+               int num_routes)
+{
+  uint8_t i;
+
+  if(event == UIP_DS6_NOTIFICATION_ROUTE_ADD ||
+     event == UIP_DS6_NOTIFICATION_ROUTE_RM) {
+    routes_gen++;
+    i = routes_gen % WEBSERVER_CONF_CHANGES;
+    if(!prefix_set || memcmp(route, &prefix, 8) != 0) {
+      changes[i].op = CHANGE_RESET;
+      return;
+    }
+    changes[i].op = event == UIP_DS6_NOTIFICATION_ROUTE_ADD ?
+      CHANGE_ADD : CHANGE_RM;
+    memcpy(changes[i].dst, &route->u8[8], 8);
+    if(nexthop != NULL) {
+      memcpy(changes[i].via, &nexthop->u8[8], 8);
+    } else {
+      memset(changes[i].via, 0, 8);
+    }
+  }
+}
+#endif /* WEBSERVER_CONF_JSON */
 
 PROCESS(webserver_nogui_process, "Web server");
 PROCESS_THREAD(webserver_nogui_process, ev, data)
@@ -94,6 +195,9 @@ PROCESS_THREAD(webserver_nogui_process, ev, data)
   PROCESS_BEGIN();
 
   httpd_init();
+#if WEBSERVER_CONF_JSON
+  uip_ds6_notification_add(&route_notification, route_callback);
+#endif
 
   while(1) {
     PROCESS_WAIT_EVENT_UNTIL(ev == tcpip_event);
@@ -106,48 +210,160 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 
 static const char *TOP = "<html><head><title>ContikiRPL</title></head><body>\n";
 static const char *BOTTOM = "</body></html>\n";
-#if BUF_USES_STACK
-static char *bufptr, *bufend;
-#define ADD(...) do {                                                   \
-    bufptr += snprintf(bufptr, bufend - bufptr, __VA_ARGS__);      \
+
+/* Format into the connection's output buffer, for the HTML page. Output
+ * that does not fit is truncated rather than overrunning the buffer.
+ */
+#define ADD(s, ...) do {                                                \
+    (s)->blen += snprintf(&(s)->outbuf[(s)->blen],                      \
+                          sizeof((s)->outbuf) - (s)->blen, __VA_ARGS__); \
+    if((s)->blen >= sizeof((s)->outbuf)) {                              \
+      (s)->blen = sizeof((s)->outbuf) - 1;                              \
+    }                                                                   \
   } while(0)
-#else
-static char buf[256];
-static int blen;
-#define ADD(...) do {                                                   \
-    blen += snprintf(&buf[blen], sizeof(buf) - blen, __VA_ARGS__);      \
+
+/* Send and empty the connection's output buffer. The buffer is not
+ * touched again until PSOCK_SEND returns, i.e. until the data is acked.
+ */
+#define SEND_BUF(s) do {                                                \
+    if((s)->blen > 0) {                                                 \
+      PSOCK_SEND(&(s)->sout, (uint8_t *)(s)->outbuf, (s)->blen);        \
+      (s)->blen = 0;                                                    \
+    }                                                                   \
   } while(0)
-#endif
 
 /*---------------------------------------------------------------------------*/
-static void
-ipaddr_add(const uip_ipaddr_t *addr)
+/* Output without snprintf, for the JSON replies. Text that does not fit
+ * in the output buffer is not written at all, and the put functions
+ * return 0; a reply entry made of several puts is rolled back as a
+ * whole, so an object is never cut.
+ */
+static int
+put_mem(struct httpd_state *s, const char *p, size_t len)
+{
+  if(s->blen + len > sizeof(s->outbuf)) {
+    return 0;
+  }
+  memcpy(&s->outbuf[s->blen], p, len);
+  s->blen += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+put_str(struct httpd_state *s, const char *str)
+{
+  return put_mem(s, str, strlen(str));
+}
+/*---------------------------------------------------------------------------*/
+static int
+put_u16(struct httpd_state *s, uint16_t v)
+{
+  char buf[5], *p = buf + sizeof(buf);
+
+  do {
+    *--p = '0' + v % 10;
+    v /= 10;
+  } while(v > 0);
+  return put_mem(s, p, buf + sizeof(buf) - p);
+}
+/*---------------------------------------------------------------------------*/
+static int
+put_u32(struct httpd_state *s, uint32_t v)
+{
+  char buf[10], *p = buf + sizeof(buf);
+
+  /* 32-bit division is a library call on msp430 */
+  if(v <= 0xffff) {
+    return put_u16(s, v);
+  }
+  do {
+    *--p = '0' + v % 10;
+    v /= 10;
+  } while(v > 0);
+  return put_mem(s, p, buf + sizeof(buf) - p);
+}
+/*---------------------------------------------------------------------------*/
+/* Append the end of a reply, sending what is buffered first if it does
+ * not fit */
+#define PUT_LAST(s, str) do {                                           \
+    if(!put_str(s, str)) {                                              \
+      SEND_BUF(s);                                                      \
+      put_str(s, str);                                                  \
+    }                                                                   \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+/* Address printer. Output is the same as the usual "first zero run
+ * becomes ::" loop, but without snprintf and with the text of the
+ * upper 64 bits cached: nearly every address printed is either
+ * link-local or inside the DAG prefix, so only the IID is formatted.
+ */
+struct prefix_text {
+  uint8_t prefix[8];
+  int8_t state;                 /* zero run state after the prefix */
+  uint8_t len;
+  char text[20];
+};
+/* [0] is fe80::/64, [1] the last other prefix printed */
+static struct prefix_text prefix_texts[2] = {
+  { { 0xfe, 0x80 }, 3, 6, "fe80::" }
+};
+static const char hexchars[] = "0123456789abcdef";
+/*---------------------------------------------------------------------------*/
+/* Format the 16-bit groups of a from byte i on; state as below */
+static char *
+format_groups(char *p, const uint8_t *a, int i, int end, int8_t *state)
 {
-  uint16_t a;
-  int i, f;
-  for(i = 0, f = 0; i < sizeof(uip_ipaddr_t); i += 2) {
-    a = (addr->u8[i] << 8) + addr->u8[i + 1];
-    if(a == 0 && f >= 0) {
-      if(f++ == 0) ADD("::");
+  uint16_t v;
+  int8_t f = *state;
+  int shift;
+
+  for(; i < end; i += 2) {
+    v = (a[i] << 8) | a[i + 1];
+    if(v == 0 && f >= 0) {
+      /* f counts the zero groups of the first run, -1 once it ended */
+      if(f++ == 0) {
+        *p++ = ':';
+        *p++ = ':';
+      }
     } else {
       if(f > 0) {
         f = -1;
       } else if(i > 0) {
-        ADD(":");
+        *p++ = ':';
+      }
+      for(shift = 12; shift > 0 && (v >> shift) == 0; shift -= 4);
+      for(; shift >= 0; shift -= 4) {
+        *p++ = hexchars[(v >> shift) & 15];
       }
-      ADD("%x", a);
     }
   }
+  *state = f;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static int
+ipaddr_add(struct httpd_state *s, const uip_ipaddr_t *addr)
+{
+  struct prefix_text *pt;
+  char buf[40], *p;
+  int8_t state;
+
+  pt = &prefix_texts[addr->u8[0] == 0xfe &&
+                     memcmp(addr, prefix_texts[0].prefix, 8) == 0 ? 0 : 1];
+  if(memcmp(addr, pt->prefix, 8) != 0 || pt->len == 0) {
+    memcpy(pt->prefix, addr, 8);
+    pt->state = 0;
+    pt->len = format_groups(pt->text, addr->u8, 0, 8, &pt->state) - pt->text;
+  }
+  memcpy(buf, pt->text, pt->len);
+  state = pt->state;
+  p = format_groups(buf + pt->len, addr->u8, 8, 16, &state);
+  return put_mem(s, buf, p - buf);
 }
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(generate_routes(struct httpd_state *s))
 {
-  static uip_ds6_route_t *r;
-  static uip_ds6_nbr_t *nbr;
-#if BUF_USES_STACK
-  char buf[256];
-#endif
 #if WEBSERVER_CONF_LOADTIME
   static clock_time_t numticks;
   numticks = clock_time();
@@ -156,128 +372,359 @@ PT_THREAD(generate_routes(struct httpd_state *s))
   PSOCK_BEGIN(&s->sout);
 
   SEND_STRING(&s->sout, TOP);
-#if BUF_USES_STACK
-  bufptr = buf;bufend=bufptr+sizeof(buf);
-#else
-  blen = 0;
-#endif
-  ADD("Neighbors<pre>");
+  s->blen = 0;
+  ADD(s, "Neighbors<pre>");
 
-  for(nbr = nbr_table_head(ds6_neighbors);
-      nbr != NULL;
-      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+  for(s->nbr = nbr_table_head(ds6_neighbors);
+      s->nbr != NULL;
+      s->nbr = nbr_table_next(ds6_neighbors, s->nbr)) {
 
 #if WEBSERVER_CONF_NEIGHBOR_STATUS
-#if BUF_USES_STACK
-{char* j=bufptr+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (bufptr < j) ADD(" ");
-      switch (nbr->state) {
-      case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
-      case NBR_REACHABLE: ADD(" REACHABLE");break;
-      case NBR_STALE: ADD(" STALE");break;
-      case NBR_DELAY: ADD(" DELAY");break;
-      case NBR_PROBE: ADD(" NBR_PROBE");break;
+{uint16_t j=s->blen+25;
+      ipaddr_add(s, &s->nbr->ipaddr);
+      while (s->blen < j) ADD(s, " ");
+      switch (s->nbr->state) {
+      case NBR_INCOMPLETE: ADD(s, " INCOMPLETE");break;
+      case NBR_REACHABLE: ADD(s, " REACHABLE");break;
+      case NBR_STALE: ADD(s, " STALE");break;
+      case NBR_DELAY: ADD(s, " DELAY");break;
+      case NBR_PROBE: ADD(s, " NBR_PROBE");break;
       }
 }
 #else
-{uint8_t j=blen+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (blen < j) ADD(" ");
-      switch (nbr->state) {
-      case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
-      case NBR_REACHABLE: ADD(" REACHABLE");break;
-      case NBR_STALE: ADD(" STALE");break;
-      case NBR_DELAY: ADD(" DELAY");break;
-      case NBR_PROBE: ADD(" NBR_PROBE");break;
-      }
-}
-#endif
-#else
-      ipaddr_add(&nbr->ipaddr);
+      ipaddr_add(s, &s->nbr->ipaddr);
 #endif
 
-      ADD("\n");
-#if BUF_USES_STACK
-      if(bufptr > bufend - 45) {
-        SEND_STRING(&s->sout, buf);
-        bufptr = buf; bufend = bufptr + sizeof(buf);
-      }
-#else
-      if(blen > sizeof(buf) - 45) {
-        SEND_STRING(&s->sout, buf);
-        blen = 0;
+      ADD(s, "\n");
+      if(s->blen > sizeof(s->outbuf) - 45) {
+        SEND_BUF(s);
       }
-#endif
   }
-  ADD("</pre>Routes<pre>");
-  SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-  bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-  blen = 0;
-#endif
+  ADD(s, "</pre>Routes<pre>");
+  SEND_BUF(s);
 
-  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+  for(s->route = uip_ds6_route_head();
+      s->route != NULL;
+      s->route = uip_ds6_route_next(s->route)) {
 
-#if BUF_USES_STACK
 #if WEBSERVER_CONF_ROUTE_LINKS
-    ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
-    ADD("]/status.shtml>");
-    ipaddr_add(&r->ipaddr);
-    ADD("</a>");
+    ADD(s, "<a href=http://[");
+    ipaddr_add(s, &s->route->ipaddr);
+    ADD(s, "]/status.shtml>");
+    SEND_BUF(s); //TODO: why tunslip6 needs an output here, wpcapslip does not
+    ipaddr_add(s, &s->route->ipaddr);
+    ADD(s, "</a>");
 #else
-    ipaddr_add(&r->ipaddr);
+    ipaddr_add(s, &s->route->ipaddr);
 #endif
-#else
-#if WEBSERVER_CONF_ROUTE_LINKS
-    ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
-    ADD("]/status.shtml>");
-    SEND_STRING(&s->sout, buf); //TODO: why tunslip6 needs an output here, wpcapslip does not
-    blen = 0;
-    ipaddr_add(&r->ipaddr);
-    ADD("</a>");
-#else
-    ipaddr_add(&r->ipaddr);
-#endif
-#endif
-    ADD("/%u (via ", r->length);
-    ipaddr_add(uip_ds6_route_nexthop(r));
-    if(1 || (r->state.lifetime < 600)) {
-      ADD(") %lus\n", (unsigned long)r->state.lifetime);
+    ADD(s, "/%u (via ", s->route->length);
+    ipaddr_add(s, uip_ds6_route_nexthop(s->route));
+    if(1 || (s->route->state.lifetime < 600)) {
+      ADD(s, ") %lus\n", (unsigned long)s->route->state.lifetime);
     } else {
-      ADD(")\n");
+      ADD(s, ")\n");
     }
-    SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-    bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-    blen = 0;
-#endif
+    SEND_BUF(s);
   }
-  ADD("</pre>");
+  ADD(s, "</pre>");
 
 #if WEBSERVER_CONF_FILESTATS
   static uint16_t numtimes;
-  ADD("<br><i>This page sent %u times</i>",++numtimes);
+  ADD(s, "<br><i>This page sent %u times</i>",++numtimes);
 #endif
 
 #if WEBSERVER_CONF_LOADTIME
   numticks = clock_time() - numticks + 1;
-  ADD(" <i>(%u.%02u sec)</i>",numticks/CLOCK_SECOND,(100*(numticks%CLOCK_SECOND))/CLOCK_SECOND));
+  ADD(s, " <i>(%u.%02u sec)</i>",numticks/CLOCK_SECOND,(100*(numticks%CLOCK_SECOND))/CLOCK_SECOND);
 #endif
 
-  SEND_STRING(&s->sout, buf);
+  SEND_BUF(s);
   SEND_STRING(&s->sout, BOTTOM);
 
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
+#if WEBSERVER_CONF_JSON
+/* Value of query parameter "<key>=" in the requested path, or def */
+static uint16_t
+query_value(const char *path, char key, uint16_t def)
+{
+  const char *p;
+  uint16_t v;
+
+  for(p = strchr(path, '?'); p != NULL; p = strchr(p + 1, '&')) {
+    if(p[1] == key && p[2] == '=' && isdigit((unsigned char)p[3])) {
+      for(v = 0, p += 3; isdigit((unsigned char)*p); p++) {
+        v = v * 10 + (*p - '0');
+      }
+      return v;
+    }
+  }
+  return def;
+}
+/*---------------------------------------------------------------------------*/
+static void
+parse_page(struct httpd_state *s)
+{
+  s->offset = query_value(s->filename, 'o', 0);
+  s->limit = query_value(s->filename, 'n', WEBSERVER_CONF_JSON_LIMIT);
+  if(s->limit > WEBSERVER_CONF_JSON_LIMIT) {
+    s->limit = WEBSERVER_CONF_JSON_LIMIT;
+  }
+  if(s->offset > 0xffff - s->limit) {
+    s->offset = 0xffff - s->limit;
+  }
+  s->index = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Entry s->index is within the requested page */
+#define IN_PAGE(s) ((s)->index >= (s)->offset && \
+                    (s)->index < (s)->offset + (s)->limit)
+/*---------------------------------------------------------------------------*/
+static int
+route_entry(struct httpd_state *s)
+{
+  uint16_t mark = s->blen;
+
+  if((s->index > s->offset && !put_str(s, ",")) ||
+     !put_str(s, "{\"dst\":\"") ||
+     !ipaddr_add(s, &s->route->ipaddr) ||
+     !put_str(s, "\",\"len\":") ||
+     !put_u16(s, s->route->length) ||
+     !put_str(s, ",\"via\":\"") ||
+     !ipaddr_add(s, uip_ds6_route_nexthop(s->route)) ||
+     !put_str(s, "\",\"lt\":") ||
+     !put_u32(s, s->route->state.lifetime) ||
+     !put_str(s, "}")) {
+    s->blen = mark;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_routes_json(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sout);
+
+  parse_page(s);
+  s->blen = 0;
+  put_str(s, "{\"gen\":");
+  put_u16(s, routes_gen);
+  put_str(s, ",\"count\":");
+  put_u16(s, uip_ds6_route_num_routes());
+  if(query_value(s->filename, 'g', routes_gen + 1) == routes_gen) {
+    /* Client is up to date, skip the table */
+    s->offset = 0;
+    s->limit = 0;
+  } else {
+    put_str(s, ",\"offset\":");
+    put_u16(s, s->offset);
+    put_str(s, ",\"routes\":[");
+  }
+
+  for(s->route = uip_ds6_route_head();
+      s->route != NULL && s->index < s->offset + s->limit;
+      s->route = uip_ds6_route_next(s->route), s->index++) {
+    if(!IN_PAGE(s)) {
+      continue;
+    }
+    /* Entries are written whole or not at all: if one does not fit,
+       send and write it again, or end the page if it never can */
+    if(!route_entry(s)) {
+      SEND_BUF(s);
+      if(!route_entry(s)) {
+        break;
+      }
+    }
+  }
+  PUT_LAST(s, s->limit > 0 ? "]}\n" : "}\n");
+  SEND_BUF(s);
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+static int
+nbr_entry(struct httpd_state *s)
+{
+  uint16_t mark = s->blen;
+
+  if((s->index > s->offset && !put_str(s, ",")) ||
+     !put_str(s, "{\"ip\":\"") ||
+     !ipaddr_add(s, &s->nbr->ipaddr) ||
+     !put_str(s, "\",\"state\":") ||
+     !put_u16(s, s->nbr->state) ||
+     !put_str(s, "}")) {
+    s->blen = mark;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_nbrs_json(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sout);
+
+  parse_page(s);
+  s->blen = 0;
+  put_str(s, "{\"offset\":");
+  put_u16(s, s->offset);
+  put_str(s, ",\"nbrs\":[");
+
+  for(s->nbr = nbr_table_head(ds6_neighbors);
+      s->nbr != NULL && s->index < s->offset + s->limit;
+      s->nbr = nbr_table_next(ds6_neighbors, s->nbr), s->index++) {
+    if(!IN_PAGE(s)) {
+      continue;
+    }
+    if(!nbr_entry(s)) {
+      SEND_BUF(s);
+      if(!nbr_entry(s)) {
+        break;
+      }
+    }
+  }
+  PUT_LAST(s, "]}\n");
+  SEND_BUF(s);
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+/* IID as a full address in the DAG prefix or link-local */
+static int
+iid_add(struct httpd_state *s, const uip_ipaddr_t *upper, const uint8_t *iid)
+{
+  uip_ipaddr_t addr;
+
+  memcpy(&addr, upper, 8);
+  memcpy(&addr.u8[8], iid, 8);
+  return ipaddr_add(s, &addr);
+}
+/*---------------------------------------------------------------------------*/
+/* Generations still in the change log, counting back from routes_gen */
+#define CHANGE_AGE(g) ((uint16_t)(routes_gen - (g)))
+/*---------------------------------------------------------------------------*/
+/* Change s->index + 1 */
+static int
+change_entry(struct httpd_state *s)
+{
+  static const uip_ipaddr_t link_local = { { 0xfe, 0x80 } };
+  uint16_t mark = s->blen, g = s->index + 1;
+  uint8_t i = g % WEBSERVER_CONF_CHANGES;
+
+  if((g != (uint16_t)(s->offset + 1) && !put_str(s, ",")) ||
+     !put_str(s, changes[i].op == CHANGE_ADD ?
+              "{\"op\":\"+\",\"dst\":\"" : "{\"op\":\"-\",\"dst\":\"") ||
+     !iid_add(s, &prefix, changes[i].dst) ||
+     (changes[i].op == CHANGE_ADD &&
+      (!put_str(s, "\",\"via\":\"") ||
+       !iid_add(s, &link_local, changes[i].via))) ||
+     !put_str(s, "\"}")) {
+    s->blen = mark;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_changes_json(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sout);
+
+  /* s->index walks from the client's generation up to routes_gen,
+     s->limit is set if the client has to reload */
+  s->index = query_value(s->filename, 'g', routes_gen - WEBSERVER_CONF_CHANGES - 1);
+  s->offset = s->index;
+  s->limit = 0;
+  s->blen = 0;
+  put_str(s, "{\"gen\":");
+  put_u16(s, routes_gen);
+  put_str(s, ",\"count\":");
+  put_u16(s, uip_ds6_route_num_routes());
+  put_str(s, ",\"changes\":[");
+
+  while(s->index != routes_gen) {
+    /* Checked after each send too: the log may have moved on meanwhile */
+    if(CHANGE_AGE(s->index) > WEBSERVER_CONF_CHANGES ||
+       changes[(uint16_t)(s->index + 1) % WEBSERVER_CONF_CHANGES].op == CHANGE_RESET) {
+      s->limit = 1;
+      break;
+    }
+    if(!change_entry(s)) {
+      if(s->blen == 0) {
+        /* Does not fit at all: the client reloads instead */
+        s->limit = 1;
+        break;
+      }
+      SEND_BUF(s);
+      continue;
+    }
+    s->index++;
+  }
+  PUT_LAST(s, s->limit ? "],\"reset\":1}\n" : "]}\n");
+  SEND_BUF(s);
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+#if WEBSERVER_CONF_DASHBOARD
+static const char dashboard[] =
+  "<html><body><pre id=t></pre><script>\n"
+  "var g,r,o;\n"
+  "function get(u,f){var x=new XMLHttpRequest();"
+  "x.onload=function(){f(JSON.parse(x.responseText))};x.open('GET',u);x.send()}\n"
+  "function full(){r={};o=0;page()}\n"
+  "function page(){get('/routes.json?o='+o,function(j){if(!o)g=j.gen;"
+  "j.routes.forEach(function(e){r[e.dst]=e.via});o+=j.routes.length;"
+  "j.routes.length?page():show()})}\n"
+  "function poll(){get('/changes.json?g='+g,function(j){if(j.reset)return full();"
+  "j.changes.forEach(function(c){if(c.op=='+')r[c.dst]=c.via;else delete r[c.dst]});"
+  "g=j.gen;show()})}\n"
+  "function show(){var s=Object.keys(r).length+' routes, generation '+g+'\\n';"
+  "for(var k in r)s+=k+' via '+r[k]+'\\n';document.getElementById('t').textContent=s}\n"
+  "full();setInterval(poll,5000)\n"
+  "</script></body></html>\n";
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_dashboard(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sout);
+  SEND_STRING(&s->sout, dashboard);
+  PSOCK_END(&s->sout);
+}
+#endif /* WEBSERVER_CONF_DASHBOARD */
+/*---------------------------------------------------------------------------*/
+/* The requested path (without the leading slash) names file, ignoring
+ * any query string */
+static int
+path_is(const char *name, const char *file)
+{
+  size_t len = strlen(file);
+  return strncmp(name, file, len) == 0 &&
+    (name[len] == '\0' || name[len] == '?');
+}
+#endif /* WEBSERVER_CONF_JSON */
+/*---------------------------------------------------------------------------*/
 httpd_simple_script_t
 httpd_simple_get_script(const char *name)
 {
+#if WEBSERVER_CONF_JSON
+  if(path_is(name, "routes.json")) {
+    return generate_routes_json;
+  }
+  if(path_is(name, "nbrs.json")) {
+    return generate_nbrs_json;
+  }
+  if(path_is(name, "changes.json")) {
+    return generate_changes_json;
+  }
+#if WEBSERVER_CONF_DASHBOARD
+  if(path_is(name, "dash.html")) {
+    return generate_dashboard;
+  }
+#endif
+#endif /* WEBSERVER_CONF_JSON */
 
   return generate_routes;
 }
@@ -310,15 +757,65 @@ request_prefix(void)
   uip_buf[0] = '?';
   uip_buf[1] = 'P';
   uip_len = 2;
-  slip_send();
+  slip_bridge_send();
   uip_len = 0;
 }
 /*---------------------------------------------------------------------------*/
-void
-set_prefix_64(uip_ipaddr_t *prefix_64)
+#if SAVE_PREFIX
+static int
+load_prefix(uip_ipaddr_t *prefix_64)
+{
+  uint8_t buf[9];
+  int fd, len;
+
+  fd = cfs_open(PREFIX_FILE, CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+  len = cfs_read(fd, buf, sizeof(buf));
+  cfs_close(fd);
+  if(len != sizeof(buf) || buf[0] != PREFIX_MAGIC) {
+    return 0;
+  }
+  memset(prefix_64, 0, 16);
+  memcpy(prefix_64, &buf[1], 8);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+save_prefix(const uip_ipaddr_t *prefix_64)
+{
+  uint8_t buf[9];
+  int fd;
+
+  buf[0] = PREFIX_MAGIC;
+  memcpy(&buf[1], prefix_64, 8);
+  cfs_remove(PREFIX_FILE);
+  fd = cfs_open(PREFIX_FILE, CFS_WRITE);
+  if(fd >= 0) {
+    cfs_write(fd, buf, sizeof(buf));
+    cfs_close(fd);
+  }
+}
+#endif /* SAVE_PREFIX */
+/*---------------------------------------------------------------------------*/
+static void
+start_dag(const uip_ipaddr_t *prefix_64)
 {
   rpl_dag_t *dag;
   uip_ipaddr_t ipaddr;
+  uip_ds6_addr_t *old;
+
+  if(prefix_set) {
+    /* Prefix changed: drop the address and indexed routes of the old one */
+    memcpy(&ipaddr, &prefix, 16);
+    uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+    old = uip_ds6_addr_lookup(&ipaddr);
+    if(old != NULL) {
+      uip_ds6_addr_rm(old);
+    }
+    route_index_init();
+  }
   memcpy(&prefix, prefix_64, 16);
   memcpy(&ipaddr, prefix_64, 16);
   prefix_set = 1;
@@ -332,23 +829,98 @@ set_prefix_64(uip_ipaddr_t *prefix_64)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Called by slip-bridge.c when the host sends '!P' */
+void
+set_prefix_64(uip_ipaddr_t *prefix_64)
+{
+  prefix_confirmed = 1;
+  process_poll(&border_router_process);
+  if(prefix_set && memcmp(&prefix, prefix_64, 8) == 0) {
+    return;
+  }
+  start_dag(prefix_64);
+#if SAVE_PREFIX
+  save_prefix(prefix_64);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+/* Host routes inside the DAG prefix are indexed by IID, see route-index.h.
+   The Makefile links with --wrap=uip_ds6_route_lookup, so the lookups of
+   the stack (forwarding, RPL) come to __wrap_uip_ds6_route_lookup() below
+   and the route list walk is __real_uip_ds6_route_lookup(). */
+static struct uip_ds6_notification index_notification;
+
+uip_ds6_route_t *__real_uip_ds6_route_lookup(uip_ipaddr_t *addr);
+uip_ds6_route_t *__wrap_uip_ds6_route_lookup(uip_ipaddr_t *addr);
+
+static int
+in_dag_prefix(const uip_ipaddr_t *addr)
+{
+  return prefix_set && memcmp(addr, &prefix, 8) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_callback(int event, uip_ipaddr_t *route, uip_ipaddr_t *nexthop,
+               int num_routes)
+{
+  uip_ds6_route_t *r;
+
+  if(!in_dag_prefix(route)) {
+    return;
+  }
+  if(event == UIP_DS6_NOTIFICATION_ROUTE_ADD) {
+    /* The one list walk per DAO, instead of one per packet */
+    r = __real_uip_ds6_route_lookup(route);
+    if(r != NULL && r->length == 128 &&
+       !route_index_add(&route->u8[8], r)) {
+      PRINTF("route index full\n");
+    }
+  } else if(event == UIP_DS6_NOTIFICATION_ROUTE_RM) {
+    route_index_remove(&route->u8[8]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Same result as the route list walk for host routes in the DAG, in
+   constant time: a /128 is the longest match there is. Anything else,
+   and routes the full index could not take, go to the route list. */
+uip_ds6_route_t *
+__wrap_uip_ds6_route_lookup(uip_ipaddr_t *addr)
+{
+  uip_ds6_route_t *r;
+
+  if(in_dag_prefix(addr)) {
+    r = route_index_lookup(&addr->u8[8]);
+    if(r != NULL) {
+      return r;
+    }
+  }
+  return __real_uip_ds6_route_lookup(addr);
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
 {
   static struct etimer et;
+  static clock_time_t backoff;
+#if SAVE_PREFIX
+  uip_ipaddr_t saved;
+#endif
 
   PROCESS_BEGIN();
 
+  stack_probe_start(60 * CLOCK_SECOND);
+
 /* While waiting for the prefix to be sent through the SLIP connection, the future
  * border router can join an existing DAG as a parent or child, or acquire a default
  * router that will later take precedence over the SLIP fallback interface.
  * Prevent that by turning the radio off until we are initialized as a DAG root.
  */
   prefix_set = 0;
+  prefix_confirmed = 0;
   NETSTACK_MAC.off(0);
 
   PROCESS_PAUSE();
 
-  SENSORS_ACTIVATE(button_sensor);
+  button_events_init(&border_router_process);
 
   PRINTF("RPL-Border router started\n");
 #if 0
@@ -359,7 +931,17 @@ PROCESS_THREAD(border_router_process, ev, data)
   NETSTACK_MAC.off(1);
 #endif
 
-  /* Request prefix until it has been received */
+  route_index_init();
+  uip_ds6_notification_add(&index_notification, index_callback);
+
+#if SAVE_PREFIX
+  if(load_prefix(&saved)) {
+    PRINTF("starting with the saved prefix\n");
+    start_dag(&saved);
+  }
+#endif
+
+  /* Without a saved prefix nothing works until the host answers */
   while(!prefix_set) {
     etimer_set(&et, CLOCK_SECOND);
     request_prefix();
@@ -375,11 +957,24 @@ PROCESS_THREAD(border_router_process, ev, data)
   print_local_addresses();
 #endif
 
+  /* Confirm a saved prefix with the host */
+  backoff = CLOCK_SECOND;
+  if(!prefix_confirmed) {
+    request_prefix();
+    etimer_set(&et, backoff);
+  }
+
   while(1) {
     PROCESS_YIELD();
-    if (ev == sensors_event && data == &button_sensor) {
+    if (ev == button_event) {
       PRINTF("Initiating global repair\n");
       rpl_repair_root(RPL_DEFAULT_INSTANCE);
+    } else if(ev == PROCESS_EVENT_TIMER && data == &et && !prefix_confirmed) {
+      request_prefix();
+      backoff = backoff < PREFIX_BACKOFF_MAX / 2 ? backoff * 2 : PREFIX_BACKOFF_MAX;
+      etimer_set(&et, backoff);
+    } else if(ev == PROCESS_EVENT_POLL && prefix_confirmed) {
+      etimer_stop(&et);
     }
   }
 
@@ -89,6 +89,8 @@ PT_THREAD(send_string(struct httpd_state *s, const char *str))
 }
 /*---------------------------------------------------------------------------*/
 const char http_content_type_html[] = "Content-type: text/html\r\n\r\n";
+const char http_content_type_json[] = "Content-type: application/json\r\n\r\n";
+const char http_json[] = ".json";
 static
 PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
 {
@@ -115,7 +117,11 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
   /*   s->ptr = http_content_type_binary; */
   /* } */
   /* SEND_STRING(&s->sout, s->ptr); */
-  SEND_STRING(&s->sout, http_content_type_html);
+  if(strstr(s->filename, http_json) != NULL) {
+    SEND_STRING(&s->sout, http_content_type_json);
+  } else {
+    SEND_STRING(&s->sout, http_content_type_html);
+  }
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
@@ -176,6 +182,7 @@ PT_THREAD(handle_input(struct httpd_state *s))
     s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
     strncpy(s->filename, s->inputbuf, sizeof(s->filename));
   }
+  s->filename[sizeof(s->filename) - 1] = 0;
 #endif /* URLCONV */
 
   webserver_log_file(&uip_conn->ripaddr, s->filename);
@@ -228,6 +235,9 @@ httpd_appcall(void *state)
     PT_INIT(&s->outputpt);
     s->script = NULL;
     s->state = STATE_WAITING;
+    s->nbr = NULL;
+    s->route = NULL;
+    s->blen = 0;
     timer_set(&s->timer, CLOCK_SECOND * 10);
     handle_connection(s);
   } else if(s != NULL) {
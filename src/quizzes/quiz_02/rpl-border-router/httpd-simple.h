@@ -41,15 +41,27 @@
 #define HTTPD_SIMPLE_H_
 
 #include "contiki-net.h"
+#include "net/ipv6/uip-ds6.h"
 
-/* The current internal border router webserver ignores the requested file name */
-/* and needs no per-connection output buffer, so save some RAM */
+/* The border router pages are selected by a short name plus query string, */
+/* see WEBSERVER_CONF_CFS_PATHLEN in project-conf.h */
 #ifndef WEBSERVER_CONF_CFS_PATHLEN
 #define HTTPD_PATHLEN 2
 #else /* WEBSERVER_CONF_CFS_CONNS */
 #define HTTPD_PATHLEN WEBSERVER_CONF_CFS_PATHLEN
 #endif /* WEBSERVER_CONF_CFS_CONNS */
 
+/* Each connection formats into its own output buffer. A segment handed to
+ * PSOCK_SEND must stay untouched until it is acked, since a retransmission
+ * resends it from the same memory. The longest line the router page emits
+ * (a route with its next hop) is about 100 bytes.
+ */
+#ifndef WEBSERVER_CONF_OUTBUF_SIZE
+#define HTTPD_OUTBUF_SIZE 128
+#else /* WEBSERVER_CONF_OUTBUF_SIZE */
+#define HTTPD_OUTBUF_SIZE WEBSERVER_CONF_OUTBUF_SIZE
+#endif /* WEBSERVER_CONF_OUTBUF_SIZE */
+
 struct httpd_state;
 typedef char (* httpd_simple_script_t)(struct httpd_state *s);
 
@@ -62,6 +74,12 @@ struct httpd_state {
   char filename[HTTPD_PATHLEN];
   httpd_simple_script_t script;
   char state;
+  /* Page generation state, kept across PSOCK yields */
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_route_t *route;
+  uint16_t index, offset, limit;
+  uint16_t blen;
+  char outbuf[HTTPD_OUTBUF_SIZE];
 };
 
 void httpd_init(void);
@@ -0,0 +1,234 @@
+/*
+ * Radio driver for the native target. Every transmitted frame is sent
+ * as one UDP datagram to 127.0.0.1:PIPE_RADIO_PEER and datagrams
+ * arriving on 127.0.0.1:PIPE_RADIO_PORT are received as frames, so a
+ * host program can play the rest of the network. Both ports can be
+ * overridden from the environment.
+ */
+
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/netstack.h"
+#include "pipe-radio.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#ifdef PIPE_RADIO_CONF_PORT
+#define PIPE_RADIO_PORT PIPE_RADIO_CONF_PORT
+#else
+#define PIPE_RADIO_PORT 60100
+#endif
+
+#define FRAME_MAX 127
+
+static int sock = -1;
+static struct sockaddr_in peer;
+
+static uint8_t tx_frame[FRAME_MAX];
+static unsigned short tx_len;
+
+/* One received frame waits here until pipe_radio_process takes it */
+static uint8_t rx_frame[FRAME_MAX];
+static int rx_len;
+
+static int listening = 1;
+
+PROCESS(pipe_radio_process, "Pipe radio");
+/*---------------------------------------------------------------------------*/
+static int
+env_port(const char *name, int def)
+{
+  const char *s = getenv(name);
+  return s != NULL ? atoi(s) : def;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  if(rx_len > 0) {
+    return 0;
+  }
+  FD_SET(sock, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  int n;
+
+  if(rx_len == 0 && FD_ISSET(sock, rset)) {
+    n = recv(sock, rx_frame, sizeof(rx_frame), 0);
+    if(n > 0 && listening) {
+      rx_len = n;
+      process_poll(&pipe_radio_process);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback radio_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+static int
+radio_init(void)
+{
+  struct sockaddr_in addr;
+  int port = env_port("PIPE_RADIO_PORT", PIPE_RADIO_PORT);
+
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if(sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("pipe-radio: bind");
+    exit(1);
+  }
+  peer = addr;
+  peer.sin_port = htons(env_port("PIPE_RADIO_PEER", port + 1));
+
+  select_set_callback(sock, &radio_callback);
+  process_start(&pipe_radio_process, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_prepare(const void *payload, unsigned short payload_len)
+{
+  if(payload_len > FRAME_MAX) {
+    return RADIO_TX_ERR;
+  }
+  memcpy(tx_frame, payload, payload_len);
+  tx_len = payload_len;
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_transmit(unsigned short transmit_len)
+{
+  if(sendto(sock, tx_frame, tx_len, 0,
+            (struct sockaddr *)&peer, sizeof(peer)) != tx_len) {
+    return RADIO_TX_ERR;
+  }
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short payload_len)
+{
+  if(radio_prepare(payload, payload_len) != RADIO_TX_OK) {
+    return RADIO_TX_ERR;
+  }
+  return radio_transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  int len = rx_len;
+
+  if(len > buf_len) {
+    len = buf_len;
+  }
+  memcpy(buf, rx_frame, len);
+  rx_len = 0;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_pending_packet(void)
+{
+  return rx_len > 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_on(void)
+{
+  listening = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_off(void)
+{
+  listening = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_get_value(radio_param_t param, radio_value_t *value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(pipe_radio_process, ev, data)
+{
+  int len;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    packetbuf_clear();
+    len = radio_read(packetbuf_dataptr(), PACKETBUF_SIZE);
+    if(len > 0) {
+      packetbuf_set_datalen(len);
+      NETSTACK_RDC.input();
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver pipe_radio_driver =
+{
+  radio_init,
+  radio_prepare,
+  radio_transmit,
+  radio_send,
+  radio_read,
+  radio_channel_clear,
+  radio_receiving_packet,
+  radio_pending_packet,
+  radio_on,
+  radio_off,
+  radio_get_value,
+  radio_set_value,
+  radio_get_object,
+  radio_set_object
+};
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,13 @@
+/*
+ * Radio driver for the native target that carries frames as UDP
+ * datagrams on the loopback interface.
+ */
+
+#ifndef PIPE_RADIO_H_
+#define PIPE_RADIO_H_
+
+#include "dev/radio.h"
+
+extern const struct radio_driver pipe_radio_driver;
+
+#endif /* PIPE_RADIO_H_ */
@@ -55,6 +55,37 @@
 #define WEBSERVER_CONF_CFS_CONNS 2
 #endif
 
+/* Room for "/routes.json?o=100&n=16&g=1234" */
+#ifndef WEBSERVER_CONF_CFS_PATHLEN
+#define WEBSERVER_CONF_CFS_PATHLEN 32
+#endif
+
+/* Downward routes, one per node below the root in storing mode. Host
+   routes inside the DAG are also indexed by IID (route-index.h); the
+   index needs a power of two number of slots, a quarter above the
+   route count.
+
+   Only the native build, for the benchmarks, holds hundreds of routes.
+   Motes keep the platform's UIP_CONF_MAX_ROUTES (20 on the Sky, a 600
+   byte pool) and the index adds 320 bytes of RAM to that: the route
+   table does not get any smaller, so a mote root does not hold more
+   routes than before. */
+#ifdef CONTIKI_TARGET_NATIVE
+#ifndef UIP_CONF_MAX_ROUTES
+#define UIP_CONF_MAX_ROUTES      500
+#endif
+#ifndef NBR_TABLE_CONF_MAX_NEIGHBORS
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 64
+#endif
+#ifndef ROUTE_INDEX_CONF_SIZE
+#define ROUTE_INDEX_CONF_SIZE    1024
+#endif
+#else
+#ifndef ROUTE_INDEX_CONF_SIZE
+#define ROUTE_INDEX_CONF_SIZE    32
+#endif
+#endif /* CONTIKI_TARGET_NATIVE */
+
 /* RF parameters define*/
 #define RF_CHANNEL    	26
 #define CC2538_RF_CONF_TX_POWER	0xFF	// +7dBm
@@ -64,4 +95,27 @@
 #define SKY_CONF_MAX_TX_POWER 	31
 #endif
 
+#ifdef CONTIKI_TARGET_NATIVE
+/* Host build for benchmarks: SLIP over a pty (slip-arch-native.c) and
+   802.15.4 frames over loopback UDP (pipe-radio.c) */
+#undef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO     pipe_radio_driver
+#undef NETSTACK_CONF_RDC
+#define NETSTACK_CONF_RDC       nullrdc_driver
+#undef NETSTACK_CONF_MAC
+#define NETSTACK_CONF_MAC       nullmac_driver
+#undef NETSTACK_CONF_NETWORK
+#define NETSTACK_CONF_NETWORK   sicslowpan_driver
+#undef NETSTACK_CONF_FRAMER
+#define NETSTACK_CONF_FRAMER    framer_802154
+#undef UIP_CONF_LL_802154
+#define UIP_CONF_LL_802154      1
+#undef UIP_CONF_LLH_LEN
+#define UIP_CONF_LLH_LEN        0
+/* Room for a longer change log */
+#define WEBSERVER_CONF_CHANGES  64
+/* Debug output goes to stdout, not into SLIP frames */
+#define SLIP_BRIDGE_CONF_NO_PUTCHAR 1
+#endif /* CONTIKI_TARGET_NATIVE */
+
 #endif /* PROJECT_ROUTER_CONF_H_ */
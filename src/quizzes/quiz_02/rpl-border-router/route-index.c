@@ -0,0 +1,112 @@
+/*
+ * Open addressing hash table with linear probing. Removal shifts the
+ * following entries back instead of leaving tombstones, so lookups of
+ * absent IIDs stop at the first empty slot even after heavy churn.
+ */
+
+#include "route-index.h"
+#include <string.h>
+
+#define MASK (ROUTE_INDEX_SIZE - 1)
+
+struct entry {
+  uint8_t iid[ROUTE_INDEX_IID_LEN];
+  void *route;                  /* NULL for a free slot */
+};
+
+static struct entry table[ROUTE_INDEX_SIZE];
+static int count;
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash(const uint8_t *iid)
+{
+  /* Node IIDs differ mostly in their last bytes; FNV-1a mixes them
+     into the low bits used for the slot */
+  uint16_t h = 0x811c;
+  int i;
+
+  for(i = 0; i < ROUTE_INDEX_IID_LEN; i++) {
+    h = (h ^ iid[i]) * 0x0193;
+  }
+  return (h ^ (h >> 8)) & MASK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+find(const uint8_t *iid)
+{
+  unsigned i = hash(iid), n;
+
+  for(n = 0; n < ROUTE_INDEX_SIZE; n++, i = (i + 1) & MASK) {
+    if(table[i].route == NULL) {
+      return -1;
+    }
+    if(memcmp(table[i].iid, iid, ROUTE_INDEX_IID_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+void
+route_index_init(void)
+{
+  memset(table, 0, sizeof(table));
+  count = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+route_index_add(const uint8_t *iid, void *route)
+{
+  unsigned i;
+  int found = find(iid);
+
+  if(found >= 0) {
+    table[found].route = route;
+    return 1;
+  }
+  if(count >= ROUTE_INDEX_SIZE - 1) {
+    return 0;
+  }
+  for(i = hash(iid); table[i].route != NULL; i = (i + 1) & MASK);
+  memcpy(table[i].iid, iid, ROUTE_INDEX_IID_LEN);
+  table[i].route = route;
+  count++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+route_index_remove(const uint8_t *iid)
+{
+  int i = find(iid);
+  unsigned j, home;
+
+  if(i < 0) {
+    return;
+  }
+  /* Move back any later entry of the cluster whose home slot is not
+     between the hole and its current position */
+  for(j = (i + 1) & MASK; table[j].route != NULL; j = (j + 1) & MASK) {
+    home = hash(table[j].iid);
+    if(((j - home) & MASK) >= ((j - i) & MASK)) {
+      table[i] = table[j];
+      i = j;
+    }
+  }
+  table[i].route = NULL;
+  count--;
+}
+/*---------------------------------------------------------------------------*/
+void *
+route_index_lookup(const uint8_t *iid)
+{
+  int i = find(iid);
+
+  return i >= 0 ? table[i].route : NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+route_index_count(void)
+{
+  return count;
+}
+/*---------------------------------------------------------------------------*/
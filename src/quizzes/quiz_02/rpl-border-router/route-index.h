@@ -0,0 +1,43 @@
+/*
+ * Hash index of the border router's downward routes, keyed by the
+ * 64-bit interface identifier of host routes inside the DAG prefix.
+ *
+ * uip_ds6_route_lookup() walks the whole route list for every lookup
+ * to find the longest match. Inside a single /64 DAG every DAO route
+ * is a /128, so the IID alone identifies it and an entry needs only
+ * the IID and a pointer to the route: 10 bytes on the msp430.
+ * The index does not own the routes; border-router.c keeps it in step
+ * with the route table through uip-ds6 notifications.
+ *
+ * This makes lookups faster, not the table smaller: the routes are
+ * still full uip_ds6_route_t entries in the uip-ds6 pool, and the index
+ * costs 10 bytes a slot on top of them.
+ */
+
+#ifndef ROUTE_INDEX_H_
+#define ROUTE_INDEX_H_
+
+#ifdef CONTIKI
+#include "contiki-conf.h"
+#endif
+#include <stdint.h>
+
+/* Number of slots, a power of two and at least a quarter larger than
+   the number of routes so probe sequences stay short */
+#ifdef ROUTE_INDEX_CONF_SIZE
+#define ROUTE_INDEX_SIZE ROUTE_INDEX_CONF_SIZE
+#else
+#define ROUTE_INDEX_SIZE 64
+#endif
+
+#define ROUTE_INDEX_IID_LEN 8
+
+void route_index_init(void);
+
+/* Returns 0 if the index is full */
+int route_index_add(const uint8_t *iid, void *route);
+void route_index_remove(const uint8_t *iid);
+void *route_index_lookup(const uint8_t *iid);
+int route_index_count(void);
+
+#endif /* ROUTE_INDEX_H_ */
@@ -0,0 +1,133 @@
+/*
+ * SLIP over a pseudo terminal for the native target, so the border
+ * router can run as a host process behind tunslip6/tunslipd or the
+ * ../../../tools/br-bench benchmark. The slave name is printed at
+ * start and, if SLIP_PTY_LINK is set in the environment, symlinked
+ * there.
+ */
+
+#define _GNU_SOURCE              /* posix_openpt() */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "dev/slip.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SLIP_END 0300
+
+static int master_fd = -1, slave_fd = -1;
+
+/* Bytes read from the pty but not yet given to slip_input_byte() */
+static uint8_t rxbuf[1024];
+static int rxpos, rxlen;
+
+static uint8_t txbuf[2 * UIP_BUFSIZE + 4];
+static int txlen;
+/*---------------------------------------------------------------------------*/
+/* Feed input up to and including the next END; the SLIP driver holds
+   one frame at a time, the rest waits for the next main loop round */
+static void
+feed(void)
+{
+  while(rxpos < rxlen) {
+    if(slip_input_byte(rxbuf[rxpos++])) {
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  if(rxpos < rxlen) {
+    /* Input pending: the master is always writable, so this makes
+       select() return at once instead of sleeping a full tick */
+    FD_SET(master_fd, wset);
+  } else {
+    FD_SET(master_fd, rset);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  int n;
+
+  if(rxpos < rxlen) {
+    feed();
+    return;
+  }
+  if(!FD_ISSET(master_fd, rset)) {
+    return;
+  }
+  n = read(master_fd, rxbuf, sizeof(rxbuf));
+  if(n > 0) {
+    rxpos = 0;
+    rxlen = n;
+    feed();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback slip_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+void
+slip_arch_writeb(unsigned char c)
+{
+  txbuf[txlen++] = c;
+  /* Flush at the end of a frame, not on a lone leading END */
+  if((c == SLIP_END && txlen > 1) || txlen == sizeof(txbuf)) {
+    int off = 0, n;
+    while(off < txlen) {
+      n = write(master_fd, txbuf + off, txlen - off);
+      if(n < 0 && errno != EINTR && errno != EAGAIN) {
+        break;
+      }
+      if(n > 0) {
+        off += n;
+      }
+    }
+    txlen = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_arch_init(unsigned long ubr)
+{
+  struct termios tty;
+  const char *name, *link;
+
+  master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master_fd < 0 || grantpt(master_fd) < 0 || unlockpt(master_fd) < 0) {
+    perror("slip: posix_openpt");
+    exit(1);
+  }
+  name = ptsname(master_fd);
+
+  /* Keep the slave open so the master does not read EIO while no host
+     is attached, and make it raw: no echo, no newline translation */
+  slave_fd = open(name, O_RDWR | O_NOCTTY);
+  if(slave_fd >= 0 && tcgetattr(slave_fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tcsetattr(slave_fd, TCSANOW, &tty);
+  }
+
+  link = getenv("SLIP_PTY_LINK");
+  if(link != NULL) {
+    unlink(link);
+    if(symlink(name, link) < 0) {
+      perror("slip: symlink");
+    }
+  }
+  fprintf(stderr, "slip: pty %s\n", name);
+
+  select_set_callback(master_fd, &slip_callback);
+}
+/*---------------------------------------------------------------------------*/
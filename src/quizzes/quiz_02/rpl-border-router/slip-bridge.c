@@ -41,7 +41,13 @@
 #include "net/ip/uip.h"
 #include "net/ipv6/uip-ds6.h"
 #include "dev/slip.h"
+#ifndef CONTIKI_TARGET_NATIVE
 #include "dev/uart1.h"
+#endif
+#include "dev/watchdog.h"
+#include "net/queuebuf.h"
+#include "lib/ringbuf.h"
+#include "lib/crc16.h"
 #include <string.h>
 
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
@@ -49,14 +55,198 @@
 #define DEBUG DEBUG_PRINT
 #include "net/ip/uip-debug.h"
 
+#ifdef SLIP_BRIDGE_CONF_BAUDRATE
+#define SLIP_BRIDGE_BAUDRATE SLIP_BRIDGE_CONF_BAUDRATE
+#else
+#define SLIP_BRIDGE_BAUDRATE 115200
+#endif
+
+/* The native target's pty SLIP (slip-arch-native.c) has no UART */
+#ifndef BAUD2UBR
+#define BAUD2UBR(baud) (baud)
+#endif
+
+/* With CRC framing every frame in both directions, including control
+ * and debug frames, carries a trailing CRC-16 (lib/crc16, low byte
+ * first). Frames received with a bad CRC are dropped. The host side
+ * must be started with the matching option (tools/slip-frame.c).
+ */
+#ifdef SLIP_BRIDGE_CONF_CRC
+#define SLIP_BRIDGE_CRC SLIP_BRIDGE_CONF_CRC
+#else
+#define SLIP_BRIDGE_CRC 0
+#endif
+
+/* Platforms with a CTS line from the host define this to test it; a
+ * frame is not started until the host is ready to receive.
+ */
+#ifdef SLIP_BRIDGE_CONF_CTS_CLEAR
+#define CTS_CLEAR() SLIP_BRIDGE_CONF_CTS_CLEAR()
+#else
+#define CTS_CLEAR() 1
+#endif
+
+/* Debug output buffer, see putchar() */
+#ifdef SLIP_BRIDGE_CONF_DEBUG_BUF_SIZE
+#define DEBUG_BUF_SIZE SLIP_BRIDGE_CONF_DEBUG_BUF_SIZE
+#else
+#define DEBUG_BUF_SIZE 128      /* Power of two, at most 128 */
+#endif
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
 void set_prefix_64(uip_ipaddr_t *);
 
 static uip_ipaddr_t last_sender;
+
+/* Frames sent back to back share one END byte; the leading END is only
+   needed to flush line noise after the link has been idle */
+static clock_time_t last_end;
+static uint8_t end_sent;
+#if SLIP_BRIDGE_CRC
+static unsigned short tx_crc;
+#endif
+
+/* Traffic counters, reported to the host on a '?S' request as '!S'
+ * followed by these values as 32-bit big-endian words, in this order,
+ * and then the queuebuf and debug buffer occupancy:
+ *   uint32 in_packets, in_bytes     SLIP -> radio
+ *   uint32 out_packets, out_bytes   radio -> SLIP
+ *   uint32 no_route                 fallback packets not bounced back
+ *   uint32 crc_errors               frames dropped on bad CRC
+ *   uint32 debug_dropped            debug output bytes dropped
+ *   uint8  queuebuf_used, queuebuf_total
+ *   uint8  debug_used, debug_total
+ */
+static struct {
+  uint32_t in_packets;
+  uint32_t in_bytes;
+  uint32_t out_packets;
+  uint32_t out_bytes;
+  uint32_t no_route;
+  uint32_t crc_errors;
+  uint32_t debug_dropped;
+} stats;
+
+#if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+PROCESS_NAME(slip_debug_process);
+static uint8_t debug_buffered(void);
+#endif
+/*---------------------------------------------------------------------------*/
+static void
+frame_writeb_raw(uint8_t c)
+{
+  if(c == SLIP_END) {
+    slip_arch_writeb(SLIP_ESC);
+    c = SLIP_ESC_END;
+  } else if(c == SLIP_ESC) {
+    slip_arch_writeb(SLIP_ESC);
+    c = SLIP_ESC_ESC;
+  }
+  slip_arch_writeb(c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_begin(void)
+{
+  while(!CTS_CLEAR()) {
+    watchdog_periodic();
+  }
+  if(!end_sent || last_end != clock_time()) {
+    slip_arch_writeb(SLIP_END);
+  }
+#if SLIP_BRIDGE_CRC
+  tx_crc = 0;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_writeb(uint8_t c)
+{
+#if SLIP_BRIDGE_CRC
+  tx_crc = crc16_add(c, tx_crc);
+#endif
+  frame_writeb_raw(c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_end(void)
+{
+#if SLIP_BRIDGE_CRC
+  frame_writeb_raw(tx_crc & 0xff);
+  frame_writeb_raw(tx_crc >> 8);
+#endif
+  slip_arch_writeb(SLIP_END);
+  last_end = clock_time();
+  end_sent = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Send uip_buf as one frame; replaces slip_send() for all output */
+void
+slip_bridge_send(void)
+{
+  uint16_t i;
+
+  frame_begin();
+  for(i = 0; i < uip_len; i++) {
+    frame_writeb(uip_buf[UIP_LLH_LEN + i]);
+  }
+  frame_end();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put32(uint8_t *p, uint32_t v)
+{
+  *p++ = v >> 24;
+  *p++ = v >> 16;
+  *p++ = v >> 8;
+  *p++ = v;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static void
+stats_send(void)
+{
+  uint8_t *p = &uip_buf[2];
+
+  uip_buf[0] = '!';
+  p = put32(p, stats.in_packets);
+  p = put32(p, stats.in_bytes);
+  p = put32(p, stats.out_packets);
+  p = put32(p, stats.out_bytes);
+  p = put32(p, stats.no_route);
+  p = put32(p, stats.crc_errors);
+  p = put32(p, stats.debug_dropped);
+  *p++ = QUEUEBUF_NUM - queuebuf_numfree();
+  *p++ = QUEUEBUF_NUM;
+#if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+  *p++ = debug_buffered();
+  *p++ = DEBUG_BUF_SIZE - 1;
+#else
+  *p++ = 0;
+  *p++ = 0;
+#endif
+  uip_len = p - uip_buf;
+  slip_bridge_send();
+}
 /*---------------------------------------------------------------------------*/
 static void
 slip_input_callback(void)
 {
  // PRINTF("SIN: %u\n", uip_len);
+#if SLIP_BRIDGE_CRC
+  if(uip_len < 2 ||
+     crc16_data(uip_buf, uip_len - 2, 0) !=
+     (uip_buf[uip_len - 2] | (uip_buf[uip_len - 1] << 8))) {
+    stats.crc_errors++;
+    uip_len = 0;
+    return;
+  }
+  uip_len -= 2;
+#endif
   if(uip_buf[0] == '!') {
     PRINTF("Got configuration message of type %c\n", uip_buf[1]);
     uip_len = 0;
@@ -82,10 +272,15 @@ slip_input_callback(void)
         uip_buf[3 + j * 2] = hexchar[uip_lladdr.addr[j] & 15];
       }
       uip_len = 18;
-      slip_send();
+      slip_bridge_send();
       
+    } else if(uip_buf[1] == 'S') {
+      stats_send();
     }
     uip_len = 0;
+  } else {
+    stats.in_packets++;
+    stats.in_bytes += uip_len;
   }
   /* Save the last sender received over SLIP to avoid bouncing the
      packet back if no route is found */
@@ -95,9 +290,12 @@ slip_input_callback(void)
 static void
 init(void)
 {
-  slip_arch_init(BAUD2UBR(115200));
+  slip_arch_init(BAUD2UBR(SLIP_BRIDGE_BAUDRATE));
   process_start(&slip_process, NULL);
   slip_set_input_callback(slip_input_callback);
+#if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+  process_start(&slip_debug_process, NULL);
+#endif
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -106,6 +304,7 @@ output(void)
   if(uip_ipaddr_cmp(&last_sender, &UIP_IP_BUF->srcipaddr)) {
     /* Do not bounce packets back over SLIP if the packet was received
        over SLIP */
+    stats.no_route++;
     PRINTF("slip-bridge: Destination off-link but no route src=");
     PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
     PRINTF(" dst=");
@@ -113,37 +312,125 @@ output(void)
     PRINTF("\n");
   } else {
  //   PRINTF("SUT: %u\n", uip_len);
-    slip_send();
+    stats.out_packets++;
+    stats.out_bytes += uip_len;
+    slip_bridge_send();
   }
 }
 
 /*---------------------------------------------------------------------------*/
 #if !SLIP_BRIDGE_CONF_NO_PUTCHAR
-#undef putchar
-int
-putchar(int c)
-{
-#define SLIP_END     0300
-  static char debug_frame = 0;
+/* Debug output is buffered in RAM and sent as SLIP debug frames ('\r'
+ * type) by a separate process, one line per scheduling round, so that
+ * PRINTF never busy-waits on the UART and IPv6 traffic over the same
+ * link is interleaved between debug lines. Output that does not fit in
+ * the buffer is dropped and counted instead of blocking.
+ */
+static struct ringbuf debug_ringbuf;
+static uint8_t debug_buf[DEBUG_BUF_SIZE];
+static uint8_t debug_ringbuf_ready;
+static uint16_t debug_dropped;
 
-  if(!debug_frame) {            /* Start of debug output */
-    slip_arch_writeb(SLIP_END);
-    slip_arch_writeb('\r');     /* Type debug line == '\r' */
-    debug_frame = 1;
+PROCESS(slip_debug_process, "SLIP debug output");
+/*---------------------------------------------------------------------------*/
+static void
+debug_frame_string(const char *str)
+{
+  while(*str) {
+    frame_writeb(*str++);
   }
+}
+/*---------------------------------------------------------------------------*/
+/* Send buffered output up to and including the next newline as one
+   debug frame. Returns 0 if there was nothing to send. */
+static int
+debug_frame_send(void)
+{
+  int c;
 
+  c = ringbuf_get(&debug_ringbuf);
+  if(c < 0) {
+    return 0;
+  }
+  frame_begin();
+  frame_writeb('\r');           /* Type debug line == '\r' */
   /* Need to also print '\n' because for example COOJA will not show
      any output before line end */
-  slip_arch_writeb((char)c);
+  while(c >= 0) {
+    frame_writeb((uint8_t)c);
+    if(c == '\n') {
+      break;
+    }
+    c = ringbuf_get(&debug_ringbuf);
+  }
+  if(c != '\n') {
+    frame_writeb('\n');
+  }
+  frame_end();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+debug_dropped_send(void)
+{
+  char num[6];
+  char *p = &num[sizeof(num) - 1];
+  uint16_t n = debug_dropped;
 
-  /*
-   * Line buffered output, a newline marks the end of debug output and
-   * implicitly flushes debug output.
-   */
-  if(c == '\n') {
-    slip_arch_writeb(SLIP_END);
-    debug_frame = 0;
+  debug_dropped = 0;
+  *p = '\0';
+  do {
+    *--p = '0' + n % 10;
+    n /= 10;
+  } while(n > 0);
+
+  frame_begin();
+  frame_writeb('\r');
+  debug_frame_string("slip-bridge: ");
+  debug_frame_string(p);
+  debug_frame_string(" debug bytes dropped\n");
+  frame_end();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+debug_buffered(void)
+{
+  return debug_ringbuf_ready ? ringbuf_elements(&debug_ringbuf) : 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(slip_debug_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    /* Pause between lines so that queued events, e.g. IPv6 packets
+       waiting for the SLIP link, are handled first */
+    while(debug_frame_send()) {
+      PROCESS_PAUSE();
+    }
+    if(debug_dropped > 0) {
+      debug_dropped_send();
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#undef putchar
+int
+putchar(int c)
+{
+  /* putchar may be called before the fallback interface is initialized */
+  if(!debug_ringbuf_ready) {
+    ringbuf_init(&debug_ringbuf, debug_buf, sizeof(debug_buf));
+    debug_ringbuf_ready = 1;
+  }
+  if(ringbuf_put(&debug_ringbuf, (uint8_t)c) == 0) {
+    debug_dropped++;
+    stats.debug_dropped++;
   }
+  process_poll(&slip_debug_process);
   return c;
 }
 #endif
@@ -0,0 +1,350 @@
+/*
+ * Turns the "#B" lines of binary logging back into the printf text
+ * (see src/apps/binlog/binlog.h). Reads a serial or Cooja log on
+ * standard input and copies it to standard output, with each "#B" line
+ * replaced by the text of its records. Whatever precedes "#B" on the
+ * line, such as the time and mote id of a Cooja log, is repeated in
+ * front of every line of text. A line of text that is split over two
+ * "#B" lines of the same mote is joined again.
+ *
+ *   binlog-decode [-i int_size] binlog.fmt... < log
+ *
+ * -i is the size of int on the mote in bytes, 2 for msp430 (default)
+ * and 4 for the native target.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct format {
+  int module, first, last, args;
+  char *text;
+};
+
+static struct format *formats;
+static int nformats;
+static int int_size = 2;
+static unsigned long unknown;
+
+/*---------------------------------------------------------------------------*/
+/* Undo the C escapes of a format as written in the source */
+static char *
+unescape(const char *s)
+{
+  char *out = malloc(strlen(s) + 1), *p = out;
+
+  for(; *s != '\0'; s++) {
+    if(*s != '\\') {
+      *p++ = *s;
+      continue;
+    }
+    switch(*++s) {
+    case 'n': *p++ = '\n'; break;
+    case 't': *p++ = '\t'; break;
+    case 'r': *p++ = '\r'; break;
+    case '\0': s--; break;
+    default: *p++ = *s; break;
+    }
+  }
+  *p = '\0';
+  return out;
+}
+/*---------------------------------------------------------------------------*/
+static int
+load_table(const char *name)
+{
+  FILE *f = fopen(name, "r");
+  char buf[1200], *q;
+  struct format fm;
+  int n;
+
+  if(f == NULL) {
+    perror(name);
+    return -1;
+  }
+  while(fgets(buf, sizeof(buf), f) != NULL) {
+    if(sscanf(buf, "%d %d %d %d \"%n", &fm.module, &fm.first, &fm.last,
+              &fm.args, &n) < 4) {
+      continue;
+    }
+    q = strrchr(buf, '"');
+    if(q == NULL || q < &buf[n]) {
+      continue;
+    }
+    *q = '\0';
+    fm.text = unescape(&buf[n]);
+    formats = realloc(formats, (nformats + 1) * sizeof(*formats));
+    formats[nformats++] = fm;
+  }
+  fclose(f);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static const struct format *
+lookup(int module, int line)
+{
+  int i;
+
+  for(i = 0; i < nformats; i++) {
+    if(formats[i].module == module &&
+       line >= formats[i].first && line <= formats[i].last) {
+      return &formats[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+base64_value(int c)
+{
+  const char *digits =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const char *p = c != '\0' ? strchr(digits, c) : NULL;
+
+  return p != NULL ? p - digits : -1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+base64_decode(const char *s, uint8_t *out)
+{
+  uint32_t v = 0;
+  size_t n = 0;
+  int bits = 0, d;
+
+  for(; (d = base64_value(*s)) >= 0; s++) {
+    v = (v << 6) | d;
+    bits += 6;
+    if(bits >= 8) {
+      bits -= 8;
+      out[n++] = v >> bits;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static const uint8_t *
+get_varint(const uint8_t *p, const uint8_t *end, int32_t *v)
+{
+  uint32_t z = 0;
+  int shift = 0;
+
+  while(p < end && shift < 35) {
+    z |= (uint32_t)(*p & 0x7f) << shift;
+    shift += 7;
+    if((*p++ & 0x80) == 0) {
+      *v = (int32_t)((z >> 1) ^ -(z & 1));
+      return p;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Append the printf text of format with arguments to out */
+static void
+format_text(char *out, size_t size, const char *fmt, const int32_t *args,
+            int nargs)
+{
+  char spec[32], piece[64];
+  size_t n = strlen(out), k;
+  int arg = 0, is_long;
+  long long v;
+  const char *p;
+
+  for(p = fmt; *p != '\0' && n + 1 < size; p++) {
+    if(*p != '%') {
+      out[n++] = *p;
+      continue;
+    }
+    if(p[1] == '%') {
+      out[n++] = '%';
+      p++;
+      continue;
+    }
+    /* Flags, width and precision go to the host printf unchanged */
+    k = 0;
+    spec[k++] = *p++;
+    while(*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && k < 20) {
+      spec[k++] = *p++;
+    }
+    is_long = 0;
+    while(*p == 'l' || *p == 'h') {
+      is_long = *p++ == 'l';
+    }
+    if(*p == '\0') {
+      break;
+    }
+    v = arg < nargs ? args[arg] : 0;
+    arg++;
+    if(!is_long && int_size == 2) {
+      v = strchr("di", *p) != NULL ? (int16_t)v : (uint16_t)v;
+    } else if(strchr("di", *p) == NULL) {
+      v = (uint32_t)v;
+    }
+    spec[k++] = 'l';
+    spec[k++] = 'l';
+    spec[k++] = *p == 'i' ? 'd' : *p;
+    spec[k] = '\0';
+    if(strchr("diuxXoc", *p) == NULL) {
+      snprintf(piece, sizeof(piece), "?");
+    } else if(*p == 'c') {
+      snprintf(piece, sizeof(piece), "%c", (char)v);
+    } else {
+      snprintf(piece, sizeof(piece), spec, v);
+    }
+    for(k = 0; piece[k] != '\0' && n + 1 < size; k++) {
+      out[n++] = piece[k];
+    }
+  }
+  out[n] = '\0';
+}
+/*---------------------------------------------------------------------------*/
+/* Text of a line not finished in the last "#B" line of a mote, kept
+   until its next "#B" line. Motes are told apart by the line prefix
+   without its leading time stamp. */
+#define PENDING_MAX 64
+
+static struct {
+  char key[32];
+  char prefix[64];
+  char text[512];
+} pending[PENDING_MAX];
+static int npending;
+
+static int
+pending_slot(const char *prefix, size_t plen)
+{
+  char key[32];
+  size_t skip = 0;
+  int i;
+
+  while(skip < plen && prefix[skip] >= '0' && prefix[skip] <= '9') {
+    skip++;
+  }
+  snprintf(key, sizeof(key), "%.*s", (int)(plen - skip), prefix + skip);
+  for(i = 0; i < npending; i++) {
+    if(strcmp(pending[i].key, key) == 0) {
+      return i;
+    }
+  }
+  if(npending == PENDING_MAX) {
+    return -1;
+  }
+  strcpy(pending[npending].key, key);
+  pending[npending].text[0] = '\0';
+  return npending++;
+}
+/*---------------------------------------------------------------------------*/
+/* Print text with prefix in front of every line. An unfinished last
+   line is kept in slot, or ended with a newline if there is none. */
+static void
+print_prefixed(const char *prefix, size_t plen, const char *text, int slot)
+{
+  const char *end;
+
+  while(*text != '\0') {
+    end = strchr(text, '\n');
+    if(end == NULL && slot >= 0 &&
+       strlen(text) < sizeof(pending[slot].text)) {
+      snprintf(pending[slot].prefix, sizeof(pending[slot].prefix), "%.*s",
+               (int)plen, prefix);
+      strcpy(pending[slot].text, text);
+      return;
+    }
+    fwrite(prefix, 1, plen, stdout);
+    if(end == NULL) {
+      printf("%s\n", text);
+      return;
+    }
+    fwrite(text, 1, end + 1 - text, stdout);
+    text = end + 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+decode_line(const char *line, const char *mark)
+{
+  static uint8_t buf[4096];
+  static char text[16384];
+  const uint8_t *p, *end;
+  const struct format *fm;
+  int32_t args[16];
+  int module, lnum, nargs, i, slot;
+
+  end = buf + base64_decode(mark + 2, buf);
+  slot = pending_slot(line, mark - line);
+  text[0] = '\0';
+  if(slot >= 0) {
+    strcpy(text, pending[slot].text);
+    pending[slot].text[0] = '\0';
+  }
+  for(p = buf; p + 3 <= end;) {
+    module = p[0];
+    lnum = p[1] | (p[2] & 0x0f) << 8;
+    nargs = p[2] >> 4;
+    p += 3;
+    for(i = 0; i < nargs && p != NULL; i++) {
+      p = get_varint(p, end, &args[i]);
+    }
+    if(p == NULL) {
+      break;
+    }
+    if(module == 0 && lnum == 0) {
+      snprintf(text + strlen(text), sizeof(text) - strlen(text),
+               "[binlog] %ld records dropped\n", (long)args[0]);
+      continue;
+    }
+    fm = lookup(module, lnum);
+    if(fm == NULL || fm->args != nargs) {
+      unknown++;
+      snprintf(text + strlen(text), sizeof(text) - strlen(text),
+               "[binlog] unknown record %d:%d\n", module, lnum);
+      continue;
+    }
+    format_text(text, sizeof(text), fm->text, args, nargs);
+  }
+  print_prefixed(line, mark - line, text, slot);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static char line[65536];
+  char *mark;
+  int i = 1;
+
+  if(argc > 2 && strcmp(argv[1], "-i") == 0) {
+    int_size = atoi(argv[2]);
+    i = 3;
+  }
+  if(i >= argc) {
+    fprintf(stderr, "usage: binlog-decode [-i int_size] binlog.fmt... < log\n");
+    return 2;
+  }
+  for(; i < argc; i++) {
+    if(load_table(argv[i]) < 0) {
+      return 1;
+    }
+  }
+
+  while(fgets(line, sizeof(line), stdin) != NULL) {
+    mark = strstr(line, "#B");
+    if(mark == NULL) {
+      fputs(line, stdout);
+      continue;
+    }
+    decode_line(line, mark);
+  }
+  for(i = 0; i < npending; i++) {
+    if(pending[i].text[0] != '\0') {
+      printf("%s%s\n", pending[i].prefix, pending[i].text);
+    }
+  }
+  if(unknown > 0) {
+    fprintf(stderr, "binlog-decode: %lu records not in the format table\n",
+            unknown);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,222 @@
+/*
+ * Format table for binlog-decode, from the BINLOG() calls in the given
+ * sources (see src/apps/binlog/binlog.h). One line per call:
+ *
+ *   <module> <first line> <last line> <arguments> "<format>"
+ *
+ * The format is kept as written in the source, escapes included, with
+ * adjacent string literals joined. A call spanning several lines is
+ * listed with its whole line range, as compilers differ in which of
+ * them __LINE__ names.
+ *
+ *   binlog-extract file.c... > binlog.fmt
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *src;
+static size_t pos, len;
+static int line;
+
+/*---------------------------------------------------------------------------*/
+static char *
+read_file(const char *name, size_t *size)
+{
+  FILE *f = fopen(name, "rb");
+  char *buf;
+  long n;
+
+  if(f == NULL) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  buf = malloc(n + 1);
+  if(buf == NULL || fread(buf, 1, n, f) != (size_t)n) {
+    fclose(f);
+    free(buf);
+    return NULL;
+  }
+  fclose(f);
+  buf[n] = '\0';
+  *size = n;
+  return buf;
+}
+/*---------------------------------------------------------------------------*/
+static void
+advance(size_t n)
+{
+  while(n-- > 0 && pos < len) {
+    if(src[pos++] == '\n') {
+      line++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Skip a comment, string or character literal at pos, if there is one */
+static int
+skip_noncode(void)
+{
+  char quote;
+
+  if(src[pos] == '/' && src[pos + 1] == '*') {
+    advance(2);
+    while(pos < len && !(src[pos] == '*' && src[pos + 1] == '/')) {
+      advance(1);
+    }
+    advance(2);
+    return 1;
+  }
+  if(src[pos] == '/' && src[pos + 1] == '/') {
+    while(pos < len && src[pos] != '\n') {
+      advance(1);
+    }
+    return 1;
+  }
+  if(src[pos] == '"' || src[pos] == '\'') {
+    quote = src[pos];
+    advance(1);
+    while(pos < len && src[pos] != quote) {
+      advance(src[pos] == '\\' ? 2 : 1);
+    }
+    advance(1);
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+skip_space(void)
+{
+  while(pos < len && (isspace((unsigned char)src[pos]) ||
+                      ((src[pos] == '/' && (src[pos + 1] == '*' ||
+                                            src[pos + 1] == '/')) &&
+                       skip_noncode()))) {
+    if(isspace((unsigned char)src[pos])) {
+      advance(1);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Parse the BINLOG( call whose '(' is at pos and print its table line */
+static int
+parse_call(const char *file, int module, int first)
+{
+  char fmt[1024];
+  size_t flen = 0;
+  int depth = 1, args = 0;
+
+  advance(1);
+  skip_space();
+  if(src[pos] != '"') {
+    fprintf(stderr, "%s:%d: BINLOG format is not a string literal\n",
+            file, first);
+    return -1;
+  }
+  /* Adjacent string literals */
+  while(src[pos] == '"') {
+    advance(1);
+    while(pos < len && src[pos] != '"') {
+      if(flen + 2 < sizeof(fmt)) {
+        fmt[flen++] = src[pos];
+        if(src[pos] == '\\') {
+          fmt[flen++] = src[pos + 1];
+        }
+      }
+      advance(src[pos] == '\\' ? 2 : 1);
+    }
+    advance(1);
+    skip_space();
+  }
+  fmt[flen] = '\0';
+
+  /* Count the arguments after the format */
+  while(pos < len && depth > 0) {
+    if(skip_noncode()) {
+      continue;
+    }
+    if(src[pos] == '(' || src[pos] == '[' || src[pos] == '{') {
+      depth++;
+    } else if(src[pos] == ')' || src[pos] == ']' || src[pos] == '}') {
+      depth--;
+    } else if(src[pos] == ',' && depth == 1) {
+      args++;
+    }
+    advance(1);
+  }
+  printf("%d %d %d %d \"%s\"\n", module, first, line, args, fmt);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+extract(const char *file)
+{
+  int module = -1, first, errors = 0;
+  size_t start;
+
+  src = read_file(file, &len);
+  if(src == NULL) {
+    perror(file);
+    return 1;
+  }
+  pos = 0;
+  line = 1;
+
+  while(pos < len) {
+    /* Preprocessor lines: look for the module number, skip the rest */
+    if(src[pos] == '#') {
+      start = pos;
+      while(pos < len && src[pos] != '\n') {
+        advance(src[pos] == '\\' ? 2 : 1);
+      }
+      sscanf(&src[start], "#define BINLOG_MODULE %d", &module);
+      continue;
+    }
+    if(skip_noncode()) {
+      continue;
+    }
+    if(isalpha((unsigned char)src[pos]) || src[pos] == '_') {
+      start = pos;
+      while(pos < len && (isalnum((unsigned char)src[pos]) || src[pos] == '_')) {
+        pos++;
+      }
+      if(pos - start == 6 && strncmp(&src[start], "BINLOG", 6) == 0) {
+        first = line;
+        skip_space();
+        if(src[pos] == '(') {
+          if(module < 0) {
+            fprintf(stderr, "%s:%d: BINLOG without BINLOG_MODULE\n",
+                    file, first);
+            errors++;
+          } else if(parse_call(file, module, first) < 0) {
+            errors++;
+          }
+        }
+      }
+      continue;
+    }
+    advance(1);
+  }
+  free(src);
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  int i, errors = 0;
+
+  if(argc < 2) {
+    fprintf(stderr, "usage: binlog-extract file.c... > binlog.fmt\n");
+    return 2;
+  }
+  for(i = 1; i < argc; i++) {
+    errors += extract(argv[i]);
+  }
+  return errors ? 1 : 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,485 @@
+/*
+ * Forwarding benchmark for the native build of the border router
+ * (make TARGET=native in quiz_02/rpl-border-router).
+ *
+ * The router is started as a child process with its SLIP link on a pty
+ * (slip-arch-native.c) and its radio on loopback UDP (pipe-radio.c);
+ * this program plays both the host tunnel and the radio neighbours.
+ * It answers the router's prefix request, learns its address with ?M
+ * and then keeps -w packets in flight:
+ *
+ *   -m echo   ICMPv6 echo requests to the router over SLIP; measures
+ *             SLIP -> uIP -> SLIP round trips
+ *   -m up     UDP from a radio neighbour to the host, sent as 802.15.4
+ *             broadcast frames with uncompressed IPv6; measures the
+ *             radio -> 6LoWPAN -> fallback -> SLIP path one way
+ *
+ * Packets per second and per-packet latency percentiles are printed,
+ * followed by the router's own counters (?S).
+ *
+ *   br-bench [-m echo|up] [-n packets] [-s size] [-w window] [-c]
+ *            [-P port] router-binary
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slip-frame.h"
+
+#define MODE_ECHO 0
+#define MODE_UP   1
+
+#define ECHO_ID   0x4252
+#define MAGIC     0x42524245UL   /* "BRBE" */
+
+static int mode = MODE_ECHO, crc;
+static unsigned long packets = 10000;
+static size_t size = 32;
+static unsigned window = 4;
+static int radio_port = 60100;
+
+static int slip_fd = -1, radio_fd = -1;
+static pid_t router_pid;
+static struct sockaddr_in radio_addr;
+static struct slip_decoder dec;
+
+static uint8_t prefix[8] = { 0xaa, 0xaa };
+static uint8_t host_addr[16], router_addr[16], node_addr[16];
+static int have_prefix_request, have_mac, have_stats, probing;
+static uint32_t router_stats[7];
+
+static unsigned long sent, received, bad, skipped;
+static double *send_time, *latency;
+
+/*---------------------------------------------------------------------------*/
+static double
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v >> 16);
+  put16(p + 2, v);
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+}
+/*---------------------------------------------------------------------------*/
+/* IPv6 upper layer checksum of the packet at ip */
+static uint16_t
+checksum(const uint8_t *ip)
+{
+  uint32_t sum;
+  size_t len = (ip[4] << 8) | ip[5], i;
+
+  sum = len + ip[6];
+  for(i = 8; i < 40; i += 2) {
+    sum += (ip[i] << 8) | ip[i + 1];
+  }
+  for(i = 0; i < len; i += 2) {
+    sum += (ip[40 + i] << 8) | (i + 1 < len ? ip[41 + i] : 0);
+  }
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return ~sum == 0 ? 0xffff : (uint16_t)~sum;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+make_ip(uint8_t *ip, uint8_t proto, const uint8_t *src, const uint8_t *dst,
+        size_t len)
+{
+  memset(ip, 0, 40);
+  ip[0] = 0x60;
+  put16(&ip[4], len);
+  ip[6] = proto;
+  ip[7] = 64;
+  memcpy(&ip[8], src, 16);
+  memcpy(&ip[24], dst, 16);
+  return 40 + len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill_payload(uint8_t *p, unsigned long seq)
+{
+  size_t i;
+
+  put32(p, MAGIC);
+  put32(p + 4, seq);
+  for(i = 8; i < size; i++) {
+    p[i] = seq + i;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_send(const uint8_t *data, size_t len)
+{
+  uint8_t frame[SLIP_FRAME_MAX(2048)];
+  size_t n = slip_frame_encode(frame, data, len, crc, 1), off = 0;
+  ssize_t w;
+
+  while(off < n) {
+    w = write(slip_fd, frame + off, n - off);
+    if(w < 0) {
+      if(errno == EAGAIN || errno == EINTR) {
+        struct pollfd p = { slip_fd, POLLOUT, 0 };
+        poll(&p, 1, 100);
+        continue;
+      }
+      perror("br-bench: write");
+      exit(1);
+    }
+    off += w;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_echo(unsigned long seq)
+{
+  uint8_t pkt[40 + 8 + 2048], *icmp = &pkt[40];
+  size_t len;
+
+  len = make_ip(pkt, 58, host_addr, router_addr, 8 + size);
+  memset(icmp, 0, 8);
+  icmp[0] = 128;
+  put16(&icmp[4], ECHO_ID);
+  put16(&icmp[6], seq);
+  fill_payload(&icmp[8], seq);
+  put16(&icmp[2], checksum(pkt));
+  slip_send(pkt, len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_up(unsigned long seq)
+{
+  uint8_t frame[127], *ip, *udp;
+  size_t hdr, len;
+  int i;
+
+  /* 802.15.4 data frame, PAN ID compression, broadcast short
+     destination, long source */
+  frame[0] = 0x41;
+  frame[1] = 0xc8;
+  frame[2] = seq;
+  frame[3] = 0xcd;
+  frame[4] = 0xab;
+  frame[5] = 0xff;
+  frame[6] = 0xff;
+  for(i = 0; i < 8; i++) {
+    frame[7 + i] = node_addr[15 - i] ^ (i == 7 ? 0x02 : 0);
+  }
+  frame[15] = 0x41;              /* 6LoWPAN uncompressed IPv6 */
+  hdr = 16;
+
+  ip = &frame[hdr];
+  udp = &ip[40];
+  len = make_ip(ip, 17, node_addr, host_addr, 8 + size);
+  put16(&udp[0], 5678);
+  put16(&udp[2], 8765);
+  put16(&udp[4], 8 + size);
+  put16(&udp[6], 0);
+  fill_payload(&udp[8], seq);
+  put16(&udp[6], checksum(ip));
+
+  sendto(radio_fd, frame, hdr + len, 0,
+         (struct sockaddr *)&radio_addr, sizeof(radio_addr));
+}
+/*---------------------------------------------------------------------------*/
+static void
+got_payload(const uint8_t *p, size_t len)
+{
+  unsigned long seq;
+
+  if(len < 8 || get32(p) != MAGIC) {
+    bad++;
+    return;
+  }
+  seq = get32(p + 4);
+  if(seq >= packets || latency[seq] != 0) {
+    bad++;
+    return;
+  }
+  latency[seq] = now_us() - send_time[seq];
+  received++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_input(void *ptr, const uint8_t *data, size_t len)
+{
+  int i;
+
+  if(len >= 2 && data[0] == '?' && data[1] == 'P') {
+    uint8_t reply[10] = { '!', 'P' };
+    memcpy(&reply[2], prefix, 8);
+    slip_send(reply, sizeof(reply));
+    have_prefix_request = 1;
+  } else if(len >= 18 && data[0] == '!' && data[1] == 'M') {
+    memcpy(router_addr, prefix, 8);
+    for(i = 0; i < 8; i++) {
+      unsigned v;
+      sscanf((const char *)&data[2 + 2 * i], "%2x", &v);
+      router_addr[8 + i] = v;
+    }
+    router_addr[8] ^= 0x02;
+    have_mac = 1;
+  } else if(len >= 30 && data[0] == '!' && data[1] == 'S') {
+    for(i = 0; i < 7; i++) {
+      router_stats[i] = get32(&data[2 + 4 * i]);
+    }
+    have_stats = 1;
+  } else if(len >= 48 && (data[0] >> 4) == 6) {
+    if((mode == MODE_ECHO || probing) && data[6] == 58 && data[40] == 129) {
+      got_payload(&data[48], len - 48);
+    } else if(mode == MODE_UP && data[6] == 17) {
+      got_payload(&data[48], len - 48);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Read and decode router output for at most ms milliseconds */
+static void
+poll_router(int ms)
+{
+  uint8_t buf[16 * 1024];
+  struct pollfd p[2] = { { slip_fd, POLLIN, 0 }, { radio_fd, POLLIN, 0 } };
+  ssize_t n;
+
+  if(poll(p, 2, ms) <= 0) {
+    return;
+  }
+  if(p[0].revents & POLLIN) {
+    n = read(slip_fd, buf, sizeof(buf));
+    if(n > 0) {
+      slip_decoder_input(&dec, buf, n, frame_input, NULL);
+    }
+  }
+  if(p[1].revents & POLLIN) {
+    /* Radio output of the router, e.g. RPL DIOs; not measured */
+    recv(radio_fd, buf, sizeof(buf), 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_router(const char *path, const char *link)
+{
+  char port[16], peer[16];
+  int i, null;
+
+  snprintf(port, sizeof(port), "%d", radio_port);
+  snprintf(peer, sizeof(peer), "%d", radio_port + 1);
+  unlink(link);
+
+  router_pid = fork();
+  if(router_pid == 0) {
+    setenv("SLIP_PTY_LINK", link, 1);
+    setenv("PIPE_RADIO_PORT", port, 1);
+    setenv("PIPE_RADIO_PEER", peer, 1);
+    null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    execl(path, path, (char *)NULL);
+    perror("br-bench: exec");
+    _exit(1);
+  }
+
+  for(i = 0; i < 100 && slip_fd < 0; i++) {
+    usleep(50000);
+    slip_fd = open(link, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  }
+  if(slip_fd < 0) {
+    fprintf(stderr, "br-bench: router did not create %s\n", link);
+    kill(router_pid, SIGTERM);
+    exit(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-m echo|up] [-n packets] [-s size] "
+          "[-w window] [-c] [-P port] router-binary\n", prog);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  struct sockaddr_in addr;
+  struct termios tty;
+  char link[64];
+  double start, elapsed, last_rx, *sorted;
+  unsigned long i, n;
+  int c;
+
+  while((c = getopt(argc, argv, "m:n:s:w:cP:")) != -1) {
+    switch(c) {
+    case 'm': mode = strcmp(optarg, "up") == 0 ? MODE_UP : MODE_ECHO; break;
+    case 'n': packets = strtoul(optarg, NULL, 0); break;
+    case 's': size = strtoul(optarg, NULL, 0); break;
+    case 'w': window = atoi(optarg); break;
+    case 'c': crc = 1; break;
+    case 'P': radio_port = atoi(optarg); break;
+    default: usage(argv[0]);
+    }
+  }
+  if(optind != argc - 1 || packets == 0 || window == 0) {
+    usage(argv[0]);
+  }
+  /* Room left in a 127 byte frame after 802.15.4, dispatch, IPv6 and
+     UDP headers, or in the router's 140 byte uip_buf for echo */
+  if(size < 8 || size > (mode == MODE_UP ? 63 : 92)) {
+    fprintf(stderr, "br-bench: size must be 8..%d\n", mode == MODE_UP ? 63 : 92);
+    exit(1);
+  }
+
+  send_time = calloc(packets, sizeof(double));
+  latency = calloc(packets, sizeof(double));
+  memcpy(host_addr, prefix, 8);
+  host_addr[15] = 1;
+  memcpy(node_addr, prefix, 8);
+  node_addr[8] = 0x02;
+  node_addr[11] = 0xff;
+  node_addr[12] = 0xfe;
+  node_addr[15] = 0x42;
+
+  radio_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(radio_port + 1);
+  if(bind(radio_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("br-bench: bind");
+    exit(1);
+  }
+  radio_addr = addr;
+  radio_addr.sin_port = htons(radio_port);
+
+  signal(SIGPIPE, SIG_IGN);
+  snprintf(link, sizeof(link), "/tmp/br-bench.%d.pty", (int)getpid());
+  start_router(argv[optind], link);
+  if(tcgetattr(slip_fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tcsetattr(slip_fd, TCSANOW, &tty);
+  }
+  slip_decoder_init(&dec, crc);
+
+  /* Give the router its prefix and wait until it answers pings */
+  for(i = 0; i < 100 && !(have_prefix_request && have_mac); i++) {
+    slip_send((const uint8_t *)"?M", 2);
+    poll_router(100);
+  }
+  if(!have_mac) {
+    fprintf(stderr, "br-bench: no answer from router\n");
+    kill(router_pid, SIGTERM);
+    exit(1);
+  }
+  probing = 1;
+  for(i = 0; i < 50 && received == 0; i++) {
+    send_time[0] = now_us();
+    send_echo(0);
+    poll_router(100);
+  }
+  if(received == 0) {
+    fprintf(stderr, "br-bench: router address not configured\n");
+    kill(router_pid, SIGTERM);
+    exit(1);
+  }
+  probing = 0;
+  received = 0;
+  latency[0] = 0;
+
+  start = last_rx = now_us();
+  while(received < packets) {
+    unsigned long before = received;
+    while(sent < packets && sent - received - skipped < window) {
+      send_time[sent] = now_us();
+      if(mode == MODE_UP) {
+        send_up(sent);
+      } else {
+        send_echo(sent);
+      }
+      sent++;
+    }
+    poll_router(10);
+    if(received != before) {
+      last_rx = now_us();
+    } else if(now_us() - last_rx > 1e6) {
+      /* Lost packets: stop after a second without progress */
+      break;
+    } else if(now_us() - last_rx > 5e4) {
+      /* Let the window move on past a lost packet */
+      skipped++;
+    }
+  }
+  elapsed = (now_us() - start) / 1e6;
+
+  sorted = malloc(received * sizeof(double));
+  for(i = 0, n = 0; i < packets; i++) {
+    if(latency[i] > 0) {
+      sorted[n++] = latency[i];
+    }
+  }
+  qsort(sorted, n, sizeof(double), cmp_double);
+
+  printf("%s: %lu/%lu packets of %zu bytes, window %u%s\n",
+         mode == MODE_UP ? "radio->slip" : "slip echo", received, sent,
+         size, window, crc ? ", crc" : "");
+  printf("  %.0f packets/s, %.1f kB/s\n", received / elapsed,
+         received * size / elapsed / 1e3);
+  if(n > 0) {
+    printf("  latency us: min %.0f p50 %.0f p99 %.0f max %.0f\n",
+           sorted[0], sorted[n / 2], sorted[n * 99 / 100], sorted[n - 1]);
+  }
+
+  for(i = 0; i < 10 && !have_stats; i++) {
+    slip_send((const uint8_t *)"?S", 2);
+    poll_router(100);
+  }
+  if(have_stats) {
+    printf("  router: in %u out %u no_route %u crc_errors %u\n",
+           router_stats[0], router_stats[2], router_stats[4],
+           router_stats[5]);
+  }
+
+  kill(router_pid, SIGTERM);
+  waitpid(router_pid, NULL, 0);
+  unlink(link);
+  return received == packets ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,176 @@
+/*
+ * Throughput test for the quiz_01 hw_interface command shell through
+ * Cooja's serial socket (Tools > Serial Socket (SERVER) on the mote).
+ *
+ * Sends -n lines of -k ';' separated commands, keeping -w lines in
+ * flight, and counts the results in the replies. Prints commands per
+ * second, mean and worst line round trip and the number of "E" results.
+ *
+ *   cmd-bench [-a host] [-p port] [-n lines] [-k commands] [-w window]
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *cycle[] = {
+  "TOGGLE RED", "TOGGLE GREEN", "STATUS", "PING", "TOGGLE BLUE", "UPTIME",
+  "BLINK RED 3 500"
+};
+#define CYCLE_LEN (sizeof(cycle) / sizeof(cycle[0]))
+
+/*---------------------------------------------------------------------------*/
+static double
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+/*---------------------------------------------------------------------------*/
+static int
+connect_to(const char *host, const char *port)
+{
+  struct addrinfo hints, *res, *r;
+  int fd = -1, one = 1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_STREAM;
+  if(getaddrinfo(host, port, &hints, &res) != 0) {
+    fprintf(stderr, "cmd-bench: cannot resolve %s\n", host);
+    exit(1);
+  }
+  for(r = res; r != NULL; r = r->ai_next) {
+    fd = socket(r->ai_family, r->ai_socktype, r->ai_protocol);
+    if(fd >= 0 && connect(fd, r->ai_addr, r->ai_addrlen) == 0) {
+      break;
+    }
+    if(fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  if(fd < 0) {
+    fprintf(stderr, "cmd-bench: cannot connect to %s:%s: %s\n",
+            host, port, strerror(errno));
+    exit(1);
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *host = "127.0.0.1", *port = "60001";
+  unsigned long lines = 1000, sent = 0, results = 0, errors = 0, expected;
+  unsigned window = 4, k = 4, i;
+  double *send_time, start, rtt_sum = 0, rtt_max = 0, elapsed;
+  char line[512], in[4096];
+  size_t inlen = 0, len;
+  unsigned long done_lines = 0;
+  int fd, c;
+
+  while((c = getopt(argc, argv, "a:p:n:k:w:")) != -1) {
+    switch(c) {
+    case 'a': host = optarg; break;
+    case 'p': port = optarg; break;
+    case 'n': lines = strtoul(optarg, NULL, 0); break;
+    case 'k': k = atoi(optarg); break;
+    case 'w': window = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-a host] [-p port] [-n lines] "
+              "[-k commands] [-w window]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(lines == 0 || k == 0 || window == 0) {
+    return 1;
+  }
+  expected = lines * k;
+  send_time = calloc(lines, sizeof(double));
+  fd = connect_to(host, port);
+
+  start = now_us();
+  while(results < expected) {
+    struct pollfd p = { fd, POLLIN, 0 };
+
+    /* A line counts as answered once all its results have arrived */
+    while(sent < lines && sent - results / k < window) {
+      for(i = 0, len = 0; i < k; i++) {
+        len += snprintf(&line[len], sizeof(line) - len, "%s%s",
+                        i > 0 ? ";" : "", cycle[(sent * k + i) % CYCLE_LEN]);
+      }
+      line[len++] = '\n';
+      if(write(fd, line, len) != (ssize_t)len) {
+        perror("cmd-bench: write");
+        return 1;
+      }
+      send_time[sent++] = now_us();
+    }
+
+    if(poll(&p, 1, 2000) <= 0) {
+      fprintf(stderr, "cmd-bench: timeout, %lu of %lu results\n",
+              results, expected);
+      break;
+    }
+    c = read(fd, &in[inlen], sizeof(in) - inlen - 1);
+    if(c <= 0) {
+      fprintf(stderr, "cmd-bench: connection closed\n");
+      break;
+    }
+    inlen += c;
+    in[inlen] = '\0';
+
+    /* Count results in every complete reply line */
+    for(;;) {
+      char *nl = strchr(in, '\n'), *r;
+      if(nl == NULL) {
+        break;
+      }
+      *nl = '\0';
+      if(strncmp(in, "Button", 6) != 0 && in[0] != '\0') {
+        for(r = in; r != NULL; r = strchr(r, ';')) {
+          if(*r == ';') {
+            r++;
+          }
+          if(r[0] == 'E' && (r[1] == ';' || r[1] == '\0' || r[1] == '\r')) {
+            errors++;
+          }
+          results++;
+          if(results % k == 0) {
+            double rtt = now_us() - send_time[done_lines++];
+            rtt_sum += rtt;
+            if(rtt > rtt_max) {
+              rtt_max = rtt;
+            }
+          }
+        }
+      }
+      inlen -= nl + 1 - in;
+      memmove(in, nl + 1, inlen + 1);
+    }
+  }
+  elapsed = (now_us() - start) / 1e6;
+
+  printf("%lu lines of %u commands, window %u: %.0f commands/s\n",
+         done_lines, k, window, results / elapsed);
+  if(done_lines > 0) {
+    printf("line round trip: mean %.1f ms, max %.1f ms, %lu errors\n",
+           rtt_sum / done_lines / 1e3, rtt_max / 1e3, errors);
+  }
+  return results == expected && errors == 0 ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,633 @@
+/*
+ * Flash and RAM footprint of the msp430 firmware images, from the
+ * linker maps (contiki-<target>.map, per module) and the ELF images
+ * (per symbol):
+ *
+ *   footprint [-n top] [-b baseline] [-w baseline] [-R ram] [-F flash]
+ *             [-S stack] dir|map|image...
+ *
+ * A directory is searched for linker maps. A map belongs to the program
+ * whose .co it loads, <program>.<target> next to it is its image. Images
+ * of other programs in the same directory (the map is overwritten by
+ * each link) are reported from the ELF alone, without modules. An image
+ * given by name is reported on its own, with the modules of the map
+ * beside it if that map is its own.
+ *
+ * For each program prints the flash (.text, .rodata, .data, .vectors)
+ * and static RAM (.data, .bss, .noinit) in use, the RAM left for the
+ * stack, and the -n (default 10) largest modules and symbols.
+ *
+ * -w writes the totals and modules of each program to a baseline file,
+ * -b compares against one and lists what grew or shrank. -R and -F set budgets for static RAM and
+ * flash, -S the least RAM to leave for the stack; the memory sizes of
+ * the map are always checked. The exit status is 1 if a budget is
+ * exceeded.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+
+/* Where an output section goes */
+enum { NONE = 0, FLASH = 1, RAM = 2 };
+
+struct usage {
+  long text = 0, data = 0, bss = 0;
+  long flash() const { return text + data; }
+  long ram() const { return data + bss; }
+};
+
+struct program {
+  string name;                  /* e.g. udp-server.sky */
+  string dir, map, elf;
+  long ram_size = 0, rom_size = 0;   /* memory sizes, 0 if unknown */
+  usage total;
+  std::map<string, usage> modules;
+  std::map<string, usage> symbols;
+};
+
+static int top = 10;
+static long budget_ram, budget_flash, budget_stack;
+static int over_budget;
+
+/*---------------------------------------------------------------------------*/
+static int
+section_class(const string &s)
+{
+  if(s == ".data") {
+    return FLASH | RAM;
+  }
+  if(s == ".bss" || s == ".noinit" || s == "COMMON" ||
+     s.compare(0, 5, ".bss.") == 0) {
+    return RAM;
+  }
+  if(s == ".text" || s == ".rodata" || s == ".vectors" || s == ".fartext" ||
+     s.compare(0, 6, ".text.") == 0 || s.compare(0, 8, ".rodata.") == 0) {
+    return FLASH;
+  }
+  return NONE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add(usage &u, int cls, long size)
+{
+  if(cls == (FLASH | RAM)) {
+    u.data += size;
+  } else if(cls == RAM) {
+    u.bss += size;
+  } else if(cls == FLASH) {
+    u.text += size;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* contiki-sky.a(csma.o) -> csma.o, obj_sky/main.o -> main.o,
+   /usr/lib/.../libc.a(rand.o) -> libc.a(rand.o) */
+static string
+module_name(string m)
+{
+  size_t paren = m.find('(');
+  size_t slash = m.rfind('/', paren);
+
+  if(slash != string::npos) {
+    m = m.substr(slash + 1);
+    paren = m.find('(');
+  }
+  if(paren != string::npos && m.compare(0, 8, "contiki-") == 0) {
+    m = m.substr(paren + 1, m.size() - paren - 2);
+  }
+  return m;
+}
+/*---------------------------------------------------------------------------*/
+static vector<string>
+words(const char *line)
+{
+  vector<string> w;
+  const char *p = line, *start;
+
+  while(*p != '\0') {
+    while(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+      p++;
+    }
+    start = p;
+    while(*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+      p++;
+    }
+    if(p > start) {
+      w.push_back(string(start, p - start));
+    }
+  }
+  return w;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+read_map(program &pr)
+{
+  FILE *f = fopen(pr.map.c_str(), "r");
+  char line[1024];
+  string out, pending;
+  int cls = NONE, part = 0;
+
+  if(f == NULL) {
+    perror(pr.map.c_str());
+    return false;
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    vector<string> w = words(line);
+
+    if(strncmp(line, "Memory Configuration", 20) == 0) {
+      part = 1;
+      continue;
+    }
+    if(strncmp(line, "Linker script and memory map", 28) == 0) {
+      part = 2;
+      continue;
+    }
+    if(part == 1 && w.size() >= 3) {
+      if(w[0] == "ram") {
+        pr.ram_size = strtol(w[2].c_str(), NULL, 16);
+      } else if(w[0] == "rom") {
+        pr.rom_size = strtol(w[2].c_str(), NULL, 16);
+      }
+      continue;
+    }
+    if(part != 2 || w.empty()) {
+      continue;
+    }
+    if(w[0] == "LOAD" && w.size() == 2 && w[1].size() > 3 &&
+       w[1].compare(w[1].size() - 3, 3, ".co") == 0) {
+      pr.name = w[1].substr(0, w[1].size() - 3);
+      continue;
+    }
+    if(line[0] != ' ') {
+      /* Output section: ".text  0x4000  0x61a6" */
+      out = w[0];
+      cls = section_class(out);
+      pending.clear();
+      continue;
+    }
+    if(cls == NONE) {
+      continue;
+    }
+    /* Input section: " .text  0x403e  0x2d0  obj_sky/contiki-sky-main.o",
+       with a long name on a line of its own */
+    if(w.size() == 1 && line[1] != ' ') {
+      pending = w[0];
+      continue;
+    }
+    bool wrapped = !pending.empty() && w.size() == 3 &&
+      w[0].compare(0, 2, "0x") == 0;
+    if(wrapped) {
+      w.insert(w.begin(), pending);
+    }
+    pending.clear();
+    if((line[1] == ' ' && !wrapped) || w.size() < 3 || w[1].compare(0, 2, "0x") != 0 ||
+       w[2].compare(0, 2, "0x") != 0) {
+      continue;
+    }
+    long size = strtol(w[2].c_str(), NULL, 16);
+    if(w[0] == "*fill*") {
+      add(pr.modules["*fill*"], cls, size);
+    } else if(w.size() >= 4) {
+      add(pr.modules[module_name(w[3])], cls, size);
+    }
+  }
+  fclose(f);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Little endian fields of an ELF32 image */
+static uint32_t
+u32(const vector<uint8_t> &b, size_t off)
+{
+  return off + 4 > b.size() ? 0 : b[off] | b[off + 1] << 8 | b[off + 2] << 16 |
+    (uint32_t)b[off + 3] << 24;
+}
+static uint16_t
+u16(const vector<uint8_t> &b, size_t off)
+{
+  return off + 2 > b.size() ? 0 : b[off] | b[off + 1] << 8;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+is_elf32(const string &path)
+{
+  FILE *f = fopen(path.c_str(), "rb");
+  unsigned char h[5] = { 0 };
+  bool ok;
+
+  if(f == NULL) {
+    return false;
+  }
+  ok = fread(h, 1, 5, f) == 5 && memcmp(h, "\x7f" "ELF", 4) == 0 && h[4] == 1;
+  fclose(f);
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
+/* Section totals and symbol sizes from the ELF image */
+static bool
+read_elf(program &pr)
+{
+  FILE *f = fopen(pr.elf.c_str(), "rb");
+  vector<uint8_t> b;
+  uint32_t shoff, shstr_off, symoff = 0, symsize = 0, stroff = 0, i;
+  uint16_t shentsize, shnum, shstrndx;
+  vector<int> cls;
+  std::map<string, int> seen;
+  bool have_totals = !pr.modules.empty();
+
+  if(f == NULL) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  b.resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  if(fread(b.data(), 1, b.size(), f) != b.size()) {
+    fclose(f);
+    return false;
+  }
+  fclose(f);
+
+  shoff = u32(b, 32);
+  shentsize = u16(b, 46);
+  shnum = u16(b, 48);
+  shstrndx = u16(b, 50);
+  if(shoff == 0 || shentsize < 40 || shoff + (size_t)shnum * shentsize > b.size()) {
+    return false;
+  }
+  shstr_off = u32(b, shoff + shstrndx * shentsize + 16);
+
+  for(i = 0; i < shnum; i++) {
+    size_t sh = shoff + i * shentsize;
+    string name((const char *)&b[std::min<size_t>(shstr_off + u32(b, sh), b.size() - 1)]);
+    uint32_t type = u32(b, sh + 4), size = u32(b, sh + 20);
+
+    cls.push_back(section_class(name));
+    if(!have_totals) {
+      add(pr.total, cls.back(), size);
+    }
+    if(type == 2) {             /* SHT_SYMTAB */
+      symoff = u32(b, sh + 16);
+      symsize = size;
+      stroff = u32(b, shoff + u32(b, sh + 24) * shentsize + 16);
+    }
+  }
+
+  for(i = 16; i + 16 <= symsize; i += 16) {
+    size_t sym = symoff + i;
+    uint32_t size = u32(b, sym + 8);
+    uint8_t type = b[sym + 12] & 0x0f;
+    uint16_t shndx = u16(b, sym + 14);
+
+    /* Functions and objects with a size, in a section we count */
+    if(size == 0 || (type != 1 && type != 2) || shndx >= cls.size() ||
+       cls[shndx] == NONE) {
+      continue;
+    }
+    string name((const char *)&b[std::min<size_t>(stroff + u32(b, sym), b.size() - 1)]);
+    /* Static symbols of the same name in different files */
+    int n = ++seen[name];
+    if(n > 1) {
+      name += "#" + std::to_string(n);
+    }
+    add(pr.symbols[name], cls[shndx], size);
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_top(const char *title, const std::map<string, usage> &items)
+{
+  vector<std::pair<string, usage>> v(items.begin(), items.end());
+
+  std::sort(v.begin(), v.end(), [](const auto &a, const auto &b) {
+      long x = a.second.ram() + a.second.flash(), y = b.second.ram() + b.second.flash();
+      return x != y ? x > y : a.first < b.first;
+    });
+  if(top > 0 && v.size() > (size_t)top) {
+    v.resize(top);
+  }
+  printf("  %-28s %6s %6s %6s %7s %6s\n", title, "text", "data", "bss", "flash", "ram");
+  for(auto &e : v) {
+    printf("  %-28s %6ld %6ld %6ld %7ld %6ld\n", e.first.c_str(), e.second.text,
+           e.second.data, e.second.bss, e.second.flash(), e.second.ram());
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(const program &pr, const char *what, long value, long limit, bool min)
+{
+  if(limit > 0 && (min ? value < limit : value > limit)) {
+    printf("  BUDGET %s/%s %s %ld %s %ld\n", pr.dir.c_str(), pr.name.c_str(), what,
+           value, min ? "<" : ">", limit);
+    over_budget = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const program &pr)
+{
+  long ram = pr.total.ram(), flash = pr.total.flash();
+
+  printf("%s/%s", pr.dir.c_str(), pr.name.c_str());
+  if(!pr.map.empty()) {
+    printf(" (%s)", pr.map.substr(pr.map.rfind('/') + 1).c_str());
+  }
+  printf("\n  flash %ld", flash);
+  if(pr.rom_size > 0) {
+    printf(" of %ld (%.1f%%)", pr.rom_size, 100.0 * flash / pr.rom_size);
+  }
+  printf("  ram %ld", ram);
+  if(pr.ram_size > 0) {
+    printf(" of %ld (%.1f%%)  stack %ld", pr.ram_size, 100.0 * ram / pr.ram_size,
+           pr.ram_size - ram);
+  }
+  printf("\n");
+
+  check(pr, "flash", flash, pr.rom_size, false);
+  check(pr, "ram", ram, pr.ram_size, false);
+  check(pr, "flash", flash, budget_flash, false);
+  check(pr, "ram", ram, budget_ram, false);
+  if(pr.ram_size > 0) {
+    check(pr, "stack", pr.ram_size - ram, budget_stack, true);
+  }
+
+  if(!pr.modules.empty()) {
+    print_top("module", pr.modules);
+  }
+  if(!pr.symbols.empty()) {
+    print_top("symbol", pr.symbols);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+/* Baseline lines: program kind name flash ram */
+typedef std::map<string, std::pair<long, long>> baseline;
+
+static void
+baseline_add(baseline &bl, const program &pr)
+{
+  string p = pr.dir + "/" + pr.name + " ";
+
+  bl[p + "total -"] = { pr.total.flash(), pr.total.ram() };
+  for(auto &m : pr.modules) {
+    bl[p + "module " + m.first] = { m.second.flash(), m.second.ram() };
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+diff(const baseline &old, const baseline &now)
+{
+  struct change { string key; long flash, ram; };
+  vector<change> v;
+  std::map<string, int> programs;
+
+  for(auto &e : now) {
+    programs[e.first.substr(0, e.first.find(' '))] = 1;
+  }
+  for(auto &e : now) {
+    auto o = old.find(e.first);
+    long f0 = o == old.end() ? 0 : o->second.first;
+    long r0 = o == old.end() ? 0 : o->second.second;
+    if(e.second.first != f0 || e.second.second != r0) {
+      v.push_back({ e.first, e.second.first - f0, e.second.second - r0 });
+    }
+  }
+  for(auto &e : old) {
+    if(now.count(e.first) == 0 && programs.count(e.first.substr(0, e.first.find(' ')))) {
+      v.push_back({ e.first, -e.second.first, -e.second.second });
+    }
+  }
+  std::stable_sort(v.begin(), v.end(), [](const change &a, const change &b) {
+      bool ta = a.key.find(" total ") != string::npos;
+      bool tb = b.key.find(" total ") != string::npos;
+      if(ta != tb) {
+        return ta;
+      }
+      return labs(a.ram) + labs(a.flash) > labs(b.ram) + labs(b.flash);
+    });
+
+  printf("Changes against the baseline:\n");
+  if(v.empty()) {
+    printf("  none\n");
+  }
+  for(auto &c : v) {
+    printf("  flash %+6ld  ram %+6ld  %s\n", c.flash, c.ram, c.key.c_str());
+  }
+}
+/*---------------------------------------------------------------------------*/
+static bool
+read_baseline(const char *path, baseline &bl)
+{
+  FILE *f = fopen(path, "r");
+  char line[1024];
+
+  if(f == NULL) {
+    perror(path);
+    return false;
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    vector<string> w = words(line);
+    if(w.size() == 5 && w[0][0] != '#') {
+      bl[w[0] + " " + w[1] + " " + w[2]] = { atol(w[3].c_str()), atol(w[4].c_str()) };
+    }
+  }
+  fclose(f);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+write_baseline(const char *path, const baseline &bl)
+{
+  FILE *f = fopen(path, "w");
+
+  if(f == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(f, "# program kind name flash ram, written by src/tools/footprint\n");
+  for(auto &e : bl) {
+    fprintf(f, "%s %ld %ld\n", e.first.c_str(), e.second.first, e.second.second);
+  }
+  fclose(f);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+is_dir(const string &path)
+{
+  struct stat st;
+
+  return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+/*---------------------------------------------------------------------------*/
+/* Programs of the linker maps in dir and its subdirectories */
+static void
+find_programs(const string &dir, vector<program> &out)
+{
+  DIR *d = opendir(dir.c_str());
+  vector<string> entries, targets;
+  struct dirent *e;
+  size_t first = out.size();
+
+  if(d == NULL) {
+    perror(dir.c_str());
+    return;
+  }
+  while((e = readdir(d)) != NULL) {
+    if(e->d_name[0] != '.') {
+      entries.push_back(e->d_name);
+    }
+  }
+  closedir(d);
+  std::sort(entries.begin(), entries.end());
+
+  for(auto &name : entries) {
+    string path = dir + "/" + name;
+    if(is_dir(path)) {
+      if(name.compare(0, 4, "obj_") != 0) {
+        find_programs(path, out);
+      }
+      continue;
+    }
+    /* contiki-<target>.map */
+    if(name.compare(0, 8, "contiki-") == 0 && name.size() > 12 &&
+       name.compare(name.size() - 4, 4, ".map") == 0) {
+      string target = name.substr(8, name.size() - 12);
+      program pr;
+      pr.dir = dir;
+      pr.map = path;
+      if(!read_map(pr) || pr.name.empty()) {
+        continue;
+      }
+      pr.name += "." + target;
+      pr.elf = dir + "/" + pr.name;
+      for(auto &m : pr.modules) {
+        pr.total.text += m.second.text;
+        pr.total.data += m.second.data;
+        pr.total.bss += m.second.bss;
+      }
+      read_elf(pr);
+      targets.push_back(target);
+      out.push_back(pr);
+    }
+  }
+
+  /* Images of the same targets without a map of their own */
+  for(auto &name : entries) {
+    for(auto &target : targets) {
+      string ext = "." + target;
+      if(name.size() <= ext.size() ||
+         name.compare(name.size() - ext.size(), ext.size(), ext) != 0) {
+        continue;
+      }
+      bool known = false;
+      for(size_t i = first; i < out.size(); i++) {
+        known |= out[i].name == name;
+      }
+      if(known || !is_elf32(dir + "/" + name)) {
+        continue;
+      }
+      program pr;
+      pr.dir = dir;
+      pr.name = name;
+      pr.elf = dir + "/" + name;
+      for(size_t i = first; i < out.size(); i++) {
+        if(out[i].name.compare(out[i].name.size() - ext.size(), ext.size(), ext) == 0) {
+          pr.ram_size = out[i].ram_size;
+          pr.rom_size = out[i].rom_size;
+        }
+      }
+      if(read_elf(pr)) {
+        out.push_back(pr);
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *base_in = NULL, *base_out = NULL;
+  vector<program> programs;
+  baseline now, old;
+  int opt;
+
+  while((opt = getopt(argc, argv, "n:b:w:R:F:S:")) != -1) {
+    switch(opt) {
+    case 'n': top = atoi(optarg); break;
+    case 'b': base_in = optarg; break;
+    case 'w': base_out = optarg; break;
+    case 'R': budget_ram = atol(optarg); break;
+    case 'F': budget_flash = atol(optarg); break;
+    case 'S': budget_stack = atol(optarg); break;
+    default:
+      fprintf(stderr, "usage: footprint [-n top] [-b baseline] [-w baseline] "
+              "[-R ram] [-F flash] [-S stack] dir|map...\n");
+      return 2;
+    }
+  }
+  if(optind == argc) {
+    fprintf(stderr, "footprint: no directory or map given\n");
+    return 2;
+  }
+  for(int i = optind; i < argc; i++) {
+    string path = argv[i];
+    while(path.size() > 1 && path.back() == '/') {
+      path.pop_back();
+    }
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : path.substr(0, slash);
+    if(is_dir(path)) {
+      find_programs(path, programs);
+    } else if(path.size() < 4 || path.compare(path.size() - 4, 4, ".map") != 0) {
+      /* An image: only that program of its directory */
+      vector<program> all;
+      size_t n = programs.size();
+      find_programs(dir, all);
+      for(auto &pr : all) {
+        if(pr.elf == path) {
+          programs.push_back(pr);
+        }
+      }
+      if(programs.size() == n) {
+        fprintf(stderr, "footprint: %s: no image with a linker map beside it\n",
+                path.c_str());
+        return 2;
+      }
+    } else {
+      /* A map: report its directory, for the images beside it */
+      find_programs(dir, programs);
+    }
+  }
+
+  for(auto &pr : programs) {
+    report(pr);
+    baseline_add(now, pr);
+  }
+  if(base_in != NULL) {
+    if(!read_baseline(base_in, old)) {
+      return 2;
+    }
+    diff(old, now);
+  }
+  if(base_out != NULL && !write_baseline(base_out, now)) {
+    return 2;
+  }
+  if(over_budget) {
+    printf("Budget exceeded\n");
+  }
+  return over_budget;
+}
+/*---------------------------------------------------------------------------*/
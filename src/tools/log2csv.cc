@@ -0,0 +1,608 @@
+/*
+ * Splits the mote output in a Cooja log into one CSV table per kind of
+ * event, for analysis outside the simulator:
+ *
+ *   log2csv [-o dir] [log]
+ *
+ * Reads the log (or standard input) and writes <dir>/<event>.csv for
+ * each event that occurs, such as beacon.csv for the "[beacon] from="
+ * lines of assignment_05. Every table starts with the columns time and
+ * mote, followed by the values of the line. Numbers are written as they
+ * were printed; addresses as a.b. Lines that are not mote output of a
+ * known format are counted and skipped.
+ *
+ * Accepted line prefixes:
+ *   time<TAB>ID:mote<TAB>       Cooja Mote output / LogListener export
+ *   time:mote:                  ScriptRunner log.log(time + ":" + id + ":" + msg)
+ *   mote<SPACE>                 ScriptRunner log.log(id + " " + msg)
+ *   (none)                      serial output of one mote, make login
+ * The time is copied as found (ScriptRunner time is in microseconds,
+ * LogListener in milliseconds); mm:ss.mmm is converted to milliseconds.
+ * Output decoded by binlog-decode keeps its prefix and reads the same.
+ *
+ * The log is read in large blocks and scanned without regular
+ * expressions or copies, so a log of a few gigabytes takes seconds.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string;
+using std::string_view;
+
+/* Line formats. In a format, "%u" and "%d" match an integer, "%a" an
+   address a.b, "%f" a number with a decimal point, "%%" a '%', a space
+   any run of spaces (or none) and "*" the rest of the line. All else
+   must match exactly. */
+enum kind {
+  PLAIN,          /* one row per line */
+  HOPS,           /* hop count histogram, one row per bin */
+  TBL_HEAD,       /* assignment_05 neighbor table heading */
+  TBL_ROW,
+  NBR_HEAD_A03,   /* assignment_03 and _04 neighbor table headings */
+  NBR_HEAD_A04,
+  NBR_ROW,
+  SKIP,           /* known, nothing to write */
+};
+
+struct event {
+  const char *name;
+  const char *format;
+  const char *columns;
+  enum kind kind;
+};
+
+static const struct event events[] = {
+  /* assignment_05 tree routing */
+  { "beacon", "[beacon] from=%u seq=%u hop=%u rssi=%d sink=%u", "from,seq,hop,rssi,sink", PLAIN },
+  { "beacon", "[beacon] from=%u seq=%u hop=%u rssi=%d", "from,seq,hop,rssi,sink", PLAIN },
+  { "beacon_fwd", "[beacon] fwd seq=%u newhop=%u", "seq,hop", PLAIN },
+  { "route", "[route] parent=%u (hop=%u rssi=%d prr=%d%%)", "parent,hop,rssi,prr", PLAIN },
+  { "aging", "[aging] parent %u expired; reset", "parent", PLAIN },
+  { "sink", "[sink] recv src=%u hops=%u temp=%f", "src,hops,temp", PLAIN },
+  { "relay", "[relay] me=%u fwd src=%u -> parent=%u", "me,src,parent", PLAIN },
+  { "ack", "[ack] from=%u data=%u", "from,data", PLAIN },
+  { "tx", "[tx] node=%u -> %u id=%u", "node,next_hop,id", PLAIN },
+  { "energest", "[energest] cpu=%u lpm=%u", "cpu,lpm", PLAIN },
+  { "hops", "[hops] *", "sink,hops,count", HOPS },
+  { "sf_store", "[sf] store src=%u id=%u queued=%u ok=%d", "src,id,queued,ok", PLAIN },
+  { "sf_drain", "[sf] drain src=%u id=%u -> %u queued=%u", "src,id,parent,queued", PLAIN },
+  { "sf_evict", "[sf] evict n=%d", "n", PLAIN },
+  { "cmd_send", "[cmd] send seq=%u dst=%u type=%u arg=%u route=%u", "seq,dst,type,arg,route", PLAIN },
+  { "cmd_fwd", "[cmd] fwd seq=%u origin=%u -> %u", "seq,origin,next_hop", PLAIN },
+  { "cmd_flood", "[cmd] flood seq=%u origin=%u hop=%u", "seq,origin,hop", PLAIN },
+  { "cmd_exec", "[cmd] exec seq=%u origin=%u type=%u arg=%u hops=%u", "seq,origin,type,arg,hops", PLAIN },
+  { NULL, "[tbl] node=%u parent=%u policy=%d", NULL, TBL_HEAD },
+  { NULL, " id  hop rssi tx ack prr%%", NULL, SKIP },
+  { "tbl", " %u %u %d %u %u %d", "parent,policy,id,hop,rssi,tx,ack,prr", TBL_ROW },
+  /* assignment_04 multihop */
+  { "tx_data", "TX data -> %a: Seq=%u Val=%d", "next_hop,seq,value", PLAIN },
+  { "root_rx", "ROOT RX data: Seq=%u from %a TTL=%u Value=%d", "seq,origin,ttl,value", PLAIN },
+  { "fwd_data", "FWD data: from %a -> %a (orig %a) TTL=%u", "from,next_hop,origin,ttl", PLAIN },
+  { "root_beacon", "ROOT beacon: seq=%u", "seq", PLAIN },
+  { "rebroadcast", "Rebcast beacon: seq=%u hop=%u", "seq,hop", PLAIN },
+  { "no_parent", "No BNN available; data not sent.", "", PLAIN },
+  /* assignment_03 and _04 neighbor tables */
+  { NULL, "Node %a \xe2\x80\x94 Neighbor stats (max %u nodes):", NULL, NBR_HEAD_A03 },
+  { NULL, "Node %a - Neighbors (max %u):", NULL, NBR_HEAD_A04 },
+  { NULL, "| Node |  RSSI |  PRR(%%) | RX_u | TX_est | Dup |", NULL, SKIP },
+  { NULL, "| Addr |  RSSI |  PRR(%%) | RX_u | TX_est | RX_ctr |", NULL, SKIP },
+  { "neighbors", "| %a | %d | %f | %u | %u | %u |",
+    "addr,rssi,prr,rx_unique,tx_est,dup,rx_ctr", NBR_ROW },
+  /* assignment_03 broadcast */
+  { "bcast_rx", "RX from %a: Seq=%u, SenderID=%a, RSSI=%d", "from,seq,sender,rssi", PLAIN },
+  { "bcast_tx", "TX: Seq=%u, Node=%a", "seq,node", PLAIN },
+  /* rpl-udp */
+  { "data_send", "DATA send to %u 'Hello %u'", "dest,seq", PLAIN },
+  { "data_recv", "DATA recv 'Hello %u from the client' from %u", "seq,src", PLAIN },
+  { "powertrace", "#P %u P %a %u %u %u %u %u %u %u %u %u %u %u %u %u *",
+    "clock,node,seqno,all_cpu,all_lpm,all_transmit,all_listen,"
+    "all_idle_transmit,all_idle_listen,cpu,lpm,transmit,listen,"
+    "idle_transmit,idle_listen", PLAIN },
+  /* assignment_01 led-stats */
+  { "led_energest", "ENERGEST t=%u hz=%u cpu=%u lpm=%u toggles=%u wakeups=%u *",
+    "t,hz,cpu,lpm,toggles,wakeups", PLAIN },
+  /* binlog-decode */
+  { "binlog_dropped", "[binlog] %u records dropped", "dropped", PLAIN },
+  /* src/apps/stack-probe */
+  { "stack", "[stack] used=%u free=%u", "used,free", PLAIN },
+};
+#define NEVENTS (sizeof(events) / sizeof(events[0]))
+#define MAX_FIELDS 16
+
+/*---------------------------------------------------------------------------*/
+/* One output table, buffered */
+class table {
+public:
+  explicit table(const struct event *e) : ev(e), buf(new char[BUF_SIZE]) {}
+  ~table() { close(); delete[] buf; }
+
+  void
+  open(const string &dir, const char *columns)
+  {
+    string path = dir + "/" + ev->name + ".csv";
+
+    file = fopen(path.c_str(), "w");
+    if(file == NULL) {
+      perror(path.c_str());
+      exit(1);
+    }
+    put("time,mote");
+    if(*columns != '\0') {
+      field(columns);
+    }
+    put("\n");
+  }
+  void
+  put(string_view v)
+  {
+    if(len + v.size() > BUF_SIZE) {
+      flush();
+      if(v.size() > BUF_SIZE) {
+        write(v.data(), v.size());
+        return;
+      }
+    }
+    memcpy(buf + len, v.data(), v.size());
+    len += v.size();
+  }
+  void
+  field(string_view v)
+  {
+    put(",");
+    put(v);
+  }
+  void
+  end_row()
+  {
+    put("\n");
+    rows++;
+  }
+  void
+  close()
+  {
+    if(file != NULL) {
+      flush();
+      fclose(file);
+      file = NULL;
+    }
+  }
+
+  const struct event *ev;
+  unsigned long rows = 0;
+
+private:
+  static const size_t BUF_SIZE = 1 << 16;
+  FILE *file = NULL;
+  char *buf;
+  size_t len = 0;
+
+  void
+  write(const char *p, size_t n)
+  {
+    if(fwrite(p, 1, n, file) != n) {
+      perror(ev->name);
+      exit(1);
+    }
+  }
+  void
+  flush()
+  {
+    write(buf, len);
+    len = 0;
+  }
+};
+
+/* Table heading last seen from a mote, for the rows that follow */
+struct mote_state {
+  enum kind heading = SKIP;
+  string parent, policy;
+  bool a04 = false;
+};
+
+static string out_dir = ".";
+static std::vector<table *> tables;
+static table *table_of[sizeof(events) / sizeof(events[0])];
+static std::vector<mote_state> motes;
+static std::vector<int> by_first_char[256];
+static size_t literal_len[NEVENTS];     /* of the format before a field */
+static int columns_of[NEVENTS];         /* after time and mote */
+static unsigned long lines, unmatched;
+
+/*---------------------------------------------------------------------------*/
+static bool
+is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+/*---------------------------------------------------------------------------*/
+/* Match s against format, storing the values found in fields */
+static int
+scan(string_view s, const char *format, string_view *fields)
+{
+  const char *p = s.data(), *end = p + s.size(), *start;
+  int n = 0;
+
+  while(*format != '\0') {
+    if(*format == ' ') {
+      while(p < end && *p == ' ') {
+        p++;
+      }
+      format++;
+      continue;
+    }
+    if(*format == '*') {
+      return n;
+    }
+    if(*format != '%' || format[1] == '%') {
+      if(p == end || *p != *format) {
+        return -1;
+      }
+      p++;
+      format += *format == '%' ? 2 : 1;
+      continue;
+    }
+    start = p;
+    if(format[1] == 'd' && p < end && *p == '-') {
+      p++;
+    }
+    if(p == end || !is_digit(*p)) {
+      return -1;
+    }
+    while(p < end && is_digit(*p)) {
+      p++;
+    }
+    if(format[1] == 'a' || format[1] == 'f') {
+      if(p == end || *p != '.') {
+        return -1;
+      }
+      p++;
+      if(p == end || !is_digit(*p)) {
+        return -1;
+      }
+      while(p < end && is_digit(*p)) {
+        p++;
+      }
+    }
+    if(n < MAX_FIELDS) {
+      fields[n++] = string_view(start, p - start);
+    }
+    format += 2;
+  }
+  /* Only trailing white space may be left */
+  while(p < end && (*p == ' ' || *p == '\r')) {
+    p++;
+  }
+  return p == end ? n : -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Table of event e, shared by the events of the same name */
+static table *
+table_for(const struct event *e)
+{
+  table *&t = table_of[e - events];
+
+  if(t != NULL) {
+    return t;
+  }
+  for(table *known : tables) {
+    if(strcmp(known->ev->name, e->name) == 0) {
+      return t = known;
+    }
+  }
+  t = new table(e);
+  t->open(out_dir, e->columns);
+  tables.push_back(t);
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+static mote_state &
+state_for(long mote)
+{
+  size_t i = mote < 0 ? 0 : mote + 1;
+
+  if(i >= motes.size()) {
+    motes.resize(i + 1);
+  }
+  return motes[i];
+}
+/*---------------------------------------------------------------------------*/
+/* Hop histogram: one row per bin, after an optional "sink=<id>" */
+static void
+write_hops(table *t, string_view time, string_view mote, string_view rest)
+{
+  const char *p = rest.data(), *end = p + rest.size(), *start;
+  char bin[12], *b;
+  int hops = 0, h;
+  string_view sink;
+
+  while(p < end && *p == ' ') {
+    p++;
+  }
+  if(end - p > 5 && string_view(p, 5) == "sink=") {
+    p += 5;
+    start = p;
+    while(p < end && is_digit(*p)) {
+      p++;
+    }
+    sink = string_view(start, p - start);
+  }
+
+  for(;;) {
+    while(p < end && *p == ' ') {
+      p++;
+    }
+    start = p;
+    if(p < end && *p == '-') {
+      p++;
+    }
+    while(p < end && is_digit(*p)) {
+      p++;
+    }
+    if(p == start) {
+      break;
+    }
+    t->put(time);
+    t->field(mote);
+    t->field(sink);
+    b = bin + sizeof(bin);
+    h = hops++;
+    do {
+      *--b = '0' + h % 10;
+      h /= 10;
+    } while(h > 0);
+    t->field(string_view(b, bin + sizeof(bin) - b));
+    t->field(string_view(start, p - start));
+    t->end_row();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle(string_view time, string_view mote, long mote_id, string_view msg)
+{
+  string_view f[MAX_FIELDS];
+  const struct event *e;
+  table *t;
+  int n, i;
+
+  if(msg.empty()) {
+    return;
+  }
+  for(int index : by_first_char[(unsigned char)msg[0]]) {
+    e = &events[index];
+    if(msg.size() < literal_len[index] ||
+       memcmp(msg.data(), e->format, literal_len[index]) != 0) {
+      continue;
+    }
+    n = scan(msg.substr(literal_len[index]), e->format + literal_len[index], f);
+    if(n < 0) {
+      continue;
+    }
+    mote_state &ms = state_for(mote_id);
+    switch(e->kind) {
+    case SKIP:
+      return;
+    case TBL_HEAD:
+      ms.heading = TBL_HEAD;
+      ms.parent.assign(f[1]);
+      ms.policy.assign(f[2]);
+      return;
+    case NBR_HEAD_A03:
+    case NBR_HEAD_A04:
+      ms.heading = NBR_ROW;
+      ms.a04 = e->kind == NBR_HEAD_A04;
+      return;
+    case TBL_ROW:
+      if(ms.heading != TBL_HEAD) {
+        continue;
+      }
+      break;
+    case NBR_ROW:
+      if(ms.heading != NBR_ROW) {
+        continue;
+      }
+      break;
+    default:
+      break;
+    }
+
+    t = table_for(e);
+    if(e->kind == HOPS) {
+      write_hops(t, time, mote, msg.substr(7));
+      return;
+    }
+    t->put(time);
+    t->field(mote);
+    if(e->kind == TBL_ROW) {
+      t->field(ms.parent);
+      t->field(ms.policy);
+    }
+    for(i = 0; i < n; i++) {
+      /* The last neighbor column is dup in assignment_03, rx_ctr in _04 */
+      if(e->kind == NBR_ROW && i == n - 1 && ms.a04) {
+        t->field("");
+      }
+      t->field(f[i]);
+    }
+    if(e->kind == NBR_ROW && !ms.a04) {
+      t->field("");
+    }
+    /* Columns of a newer format of the same event left empty */
+    for(; e->kind == PLAIN && i < columns_of[index]; i++) {
+      t->field("");
+    }
+    t->end_row();
+    return;
+  }
+  unmatched++;
+}
+/*---------------------------------------------------------------------------*/
+/* Convert [hh:]mm:ss.mmm to milliseconds in buf */
+static string_view
+time_ms(string_view s, char *buf, size_t size)
+{
+  unsigned long ms = 0, part = 0;
+  int frac = -1;
+
+  for(char c : s) {
+    if(is_digit(c)) {
+      part = part * 10 + (c - '0');
+      if(frac >= 0) {
+        frac++;
+      }
+    } else if(c == ':') {
+      ms = (ms + part) * 60;
+      part = 0;
+    } else if(c == '.' && frac < 0) {
+      ms = (ms + part) * 1000;
+      part = 0;
+      frac = 0;
+    } else {
+      return s;
+    }
+  }
+  if(frac < 0) {
+    ms = (ms + part) * 1000;
+  } else {
+    for(; frac < 3; frac++) {
+      part *= 10;
+    }
+    ms += part;
+  }
+  return string_view(buf, snprintf(buf, size, "%lu", ms));
+}
+/*---------------------------------------------------------------------------*/
+/* Split off the line prefix and hand the mote output on */
+static void
+line(string_view s)
+{
+  string_view time, mote;
+  size_t tab, colon, i;
+  char buf[24];
+  long id = -1;
+
+  lines++;
+  if(!s.empty() && s.back() == '\r') {
+    s.remove_suffix(1);
+  }
+
+  tab = s.find('\t');
+  if(tab != string_view::npos) {
+    /* time<TAB>ID:n<TAB>msg */
+    time = s.substr(0, tab);
+    s.remove_prefix(tab + 1);
+    tab = s.find('\t');
+    if(tab == string_view::npos || s.compare(0, 3, "ID:") != 0) {
+      unmatched++;
+      return;
+    }
+    mote = s.substr(3, tab - 3);
+    s.remove_prefix(tab + 1);
+    if(time.find(':') != string_view::npos) {
+      time = time_ms(time, buf, sizeof(buf));
+    }
+  } else {
+    for(i = 0; i < s.size() && is_digit(s[i]); i++);
+    if(i > 0 && i < s.size() && s[i] == ':') {
+      /* time:id:msg */
+      colon = i;
+      for(i++; i < s.size() && is_digit(s[i]); i++);
+      if(i > colon + 1 && i < s.size() && s[i] == ':') {
+        time = s.substr(0, colon);
+        mote = s.substr(colon + 1, i - colon - 1);
+        s.remove_prefix(i + 1);
+      }
+    } else if(i > 0 && i < s.size() && s[i] == ' ') {
+      /* id msg */
+      mote = s.substr(0, i);
+      s.remove_prefix(i + 1);
+    }
+  }
+  for(char c : mote) {
+    if(!is_digit(c)) {
+      id = -1;
+      break;
+    }
+    id = (id < 0 ? 0 : id * 10) + (c - '0');
+  }
+  handle(time, mote, id, s);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static char block[1 << 22];
+  size_t have = 0, n, start, i;
+  const char *nl;
+  unsigned long long bytes = 0;
+  FILE *in = stdin;
+  int opt;
+
+  while((opt = getopt(argc, argv, "o:")) != -1) {
+    if(opt == 'o') {
+      out_dir = optarg;
+    } else {
+      fprintf(stderr, "usage: log2csv [-o dir] [log]\n");
+      return 2;
+    }
+  }
+  if(optind < argc) {
+    in = fopen(argv[optind], "rb");
+    if(in == NULL) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+  mkdir(out_dir.c_str(), 0777);
+
+  for(i = 0; i < NEVENTS; i++) {
+    by_first_char[(unsigned char)events[i].format[0]].push_back(i);
+    literal_len[i] = strcspn(events[i].format, "% *");
+    if(events[i].columns != NULL && events[i].columns[0] != '\0') {
+      columns_of[i] = 1 + std::count(events[i].columns,
+                                     events[i].columns + strlen(events[i].columns), ',');
+    }
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  while((n = fread(block + have, 1, sizeof(block) - have, in)) > 0 ||
+        have > 0) {
+    bytes += n;
+    have += n;
+    start = 0;
+    while((nl = (const char *)memchr(block + start, '\n', have - start)) != NULL) {
+      line(string_view(block + start, nl - (block + start)));
+      start = nl - block + 1;
+    }
+    if(n == 0 || (start == 0 && have == sizeof(block))) {
+      /* Last line without newline, or a line longer than the block */
+      line(string_view(block + start, have - start));
+      start = have;
+    }
+    memmove(block, block + start, have - start);
+    have -= start;
+  }
+  if(ferror(in)) {
+    perror("read");
+    return 1;
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  for(table *t : tables) {
+    fprintf(stderr, "%-16s %10lu rows\n", t->ev->name, t->rows);
+    t->close();
+  }
+  fprintf(stderr, "%lu lines, %lu not recognized, %.1f MB in %.2f s\n",
+          lines, unmatched, bytes / 1e6, s);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
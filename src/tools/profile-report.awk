@@ -0,0 +1,126 @@
+# Cycle profile report of src/tools/cooja-profile, from the #PROF and
+# #STACK lines of a COOJA.testlog:
+#
+#   awk [-v stacks=stacks.folded] [-v top=30] -f profile-report.awk COOJA.testlog
+#
+# For each mote type prints the functions by the cycles spent in them
+# (summed over the motes of the type), with the calls and the share of
+# the call stack samples in which the function was running. The sampled
+# stacks go to the file stacks, one "type;outer;...;inner count" line per
+# stack as flamegraph.pl expects.
+
+BEGIN {
+  if(top == "")
+    top = 30
+}
+
+function numeric(s) {
+  return s ~ /^-?[0-9]+(\.[0-9]+)?%?$/
+}
+
+# Header of the MSPSim profile: the column names after "Function"
+$1 == "#PROF" && $4 ~ /^Function/ {
+  ncols = 0
+  for(i = 5; i <= NF; i++)
+    cols[++ncols] = $i
+  next
+}
+
+$1 == "#PROF" && ncols > 0 {
+  type = $2
+  # The name may contain spaces, the numbers are the last fields
+  for(n = NF; n > 3 && numeric($n); n--)
+    ;
+  if(n == NF || n < 4)
+    next
+  name = $4
+  for(i = 5; i <= n; i++)
+    name = name " " $i
+  types[type] = 1
+  fn[type, name] = 1
+  for(i = n + 1; i <= NF; i++) {
+    c = cols[ncols - (NF - i)]
+    v = $i
+    sub(/%$/, "", v)
+    val[type, name, c] += v
+    colseen[c] = 1
+  }
+  next
+}
+
+$1 == "#STACK" {
+  type = $2
+  count = $3
+  frames = $4
+  for(i = 5; i <= NF; i++)
+    frames = frames " " $i
+  types[type] = 1
+  folded[type ";" frames] += count
+  samples[type] += count
+  leaf = frames
+  sub(/.*;/, "", leaf)
+  fn[type, leaf] = 1
+  self[type, leaf] += count
+}
+
+# The column to sort by: exclusive cycles if the profiler gives them,
+# else total cycles, else the last column
+function key_column(   c) {
+  for(c in colseen)
+    if(tolower(c) ~ /excl/)
+      return c
+  for(c in colseen)
+    if(tolower(c) ~ /cycles|total/)
+      return c
+  return ncols > 0 ? cols[ncols] : ""
+}
+
+END {
+  key = key_column()
+  for(c in colseen)
+    if(tolower(c) ~ /call/)
+      calls = c
+
+  for(type in types) {
+    n = 0
+    total = 0
+    for(k in fn) {
+      split(k, part, SUBSEP)
+      if(part[1] != type)
+        continue
+      names[++n] = part[2]
+      score[n] = key != "" ? val[type, part[2], key] : self[type, part[2]]
+      total += score[n]
+    }
+    # Insertion sort, largest first
+    for(i = 2; i <= n; i++) {
+      s = score[i]
+      nm = names[i]
+      for(j = i - 1; j >= 1 && score[j] < s; j--) {
+        score[j + 1] = score[j]
+        names[j + 1] = names[j]
+      }
+      score[j + 1] = s
+      names[j + 1] = nm
+    }
+
+    printf("%s: %d functions, %d stack samples\n", type, n, samples[type])
+    printf("  %12s %6s %10s %8s  %s\n", key != "" ? key : "samples", "%",
+           "calls", "running", "function")
+    for(i = 1; i <= n && i <= top; i++) {
+      printf("  %12d %5.1f%% %10s %7.1f%%  %s\n", score[i],
+             total > 0 ? 100 * score[i] / total : 0,
+             calls != "" ? val[type, names[i], calls] + 0 : "-",
+             samples[type] > 0 ? 100 * self[type, names[i]] / samples[type] : 0,
+             names[i])
+    }
+    printf("\n")
+  }
+
+  if(stacks != "") {
+    printf("") > stacks
+    for(s in folded)
+      printf("%s %d\n", s, folded[s]) > stacks
+    close(stacks)
+  }
+}
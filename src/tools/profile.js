@@ -0,0 +1,71 @@
+/*
+ * Cooja script of src/tools/cooja-profile. Every @INTERVAL@ ms of
+ * simulated time it takes the call stack of each MSPSim mote from the
+ * MSPSim profiler, and at the end it logs the stacks, counted per mote
+ * type, and the profile (cycles per function) of every mote:
+ *
+ *   #STACK <mote type> <count> <outermost>;...;<innermost>
+ *   #PROF <mote type> <mote id> <line of the MSPSim "profile" command>
+ */
+TIMEOUT(@TIMEOUT@, report());
+
+var stacks = {};
+
+function is_msp(m) {
+  return m.executeCLICommand != undefined;
+}
+
+function sample() {
+  var motes = sim.getMotes();
+  var i, j, out, frames, f;
+
+  for(i = 0; i < motes.length; i++) {
+    if(!is_msp(motes[i])) {
+      continue;
+    }
+    /* "Stack Trace: ..." and then one indented line per call, the
+       innermost first: "  <function> called from PC: ..." */
+    out = String(motes[i].executeCLICommand("stacktrace")).split("\n");
+    frames = [];
+    for(j = 1; j < out.length; j++) {
+      f = out[j].match(/^\s+(\S+)/);
+      if(f != null) {
+        frames.unshift(f[1]);
+      }
+    }
+    if(frames.length > 0) {
+      f = motes[i].getType().getIdentifier() + " " + frames.join(";");
+      stacks[f] = (stacks[f] || 0) + 1;
+    }
+  }
+}
+
+function report() {
+  var motes = sim.getMotes();
+  var i, j, s, out, type;
+
+  for(s in stacks) {
+    type = s.substring(0, s.indexOf(" "));
+    log.log("#STACK " + type + " " + stacks[s] + " " + s.substring(type.length + 1) + "\n");
+  }
+  for(i = 0; i < motes.length; i++) {
+    if(!is_msp(motes[i])) {
+      continue;
+    }
+    type = motes[i].getType().getIdentifier();
+    out = String(motes[i].executeCLICommand("profile")).split("\n");
+    for(j = 0; j < out.length; j++) {
+      if(out[j].trim() != "") {
+        log.log("#PROF " + type + " " + motes[i].getID() + " " + out[j] + "\n");
+      }
+    }
+  }
+  log.testOK();
+}
+
+GENERATE_MSG(@INTERVAL@, "profile-sample");
+while(1) {
+  YIELD_THEN_WAIT_UNTIL(msg.equals("profile-sample"));
+  sample();
+  GENERATE_MSG(@INTERVAL@, "profile-sample");
+}
@@ -0,0 +1,169 @@
+/*
+ * Lookup cost of the border router's downward routes: a route list
+ * walked for the longest match as uip_ds6_route_lookup() does, against
+ * the IID index of quiz_02/rpl-border-router/route-index.c which is
+ * compiled in unchanged.
+ *
+ * The list is synthetic: Contiki's route table is not part of this
+ * tree, so its entries only mirror uip_ds6_route_t's layout and the
+ * walk is a copy of the lookup loop. Lookups alternate between routed
+ * nodes and addresses without a route, which are the worst case for
+ * the list.
+ *
+ *   route-bench [-l lookups] [routes ...]      (default 50 200 500)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "route-index.h"
+
+struct route {
+  struct route *next;
+  void *neighbor_routes;
+  uint8_t ipaddr[16];
+  uint8_t length;
+  uint8_t state[5];
+};
+
+static struct route *routes, *head;
+static uint8_t (*addrs)[16];
+
+/*---------------------------------------------------------------------------*/
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prefix_match(const uint8_t *a, const uint8_t *b, int len)
+{
+  int bytes = len / 8, bits = len % 8;
+
+  if(memcmp(a, b, bytes) != 0) {
+    return 0;
+  }
+  return bits == 0 ||
+    ((a[bytes] ^ b[bytes]) & (0xff << (8 - bits))) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static struct route *
+list_lookup(const uint8_t *addr)
+{
+  struct route *r, *found = NULL;
+  int longest = 0;
+
+  for(r = head; r != NULL; r = r->next) {
+    if(r->length >= longest && prefix_match(addr, r->ipaddr, r->length)) {
+      longest = r->length;
+      found = r;
+    }
+  }
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_addr(uint8_t *addr, int id)
+{
+  /* aaaa::212:7400:xx:yy, as Sky motes derive from their node ID */
+  memset(addr, 0, 16);
+  addr[0] = addr[1] = 0xaa;
+  addr[8] = 0x02;
+  addr[9] = 0x12;
+  addr[10] = 0x74;
+  addr[13] = id >> 8;
+  addr[14] = id;
+  addr[15] = id;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(int n, long lookups)
+{
+  struct route *r;
+  volatile void *sink;
+  double t0, t_list, t_index;
+  long i, miss = 0;
+  int k;
+
+  routes = calloc(n, sizeof(*routes));
+  addrs = calloc(2 * n, 16);
+  head = NULL;
+  route_index_init();
+  for(k = 0; k < n; k++) {
+    node_addr(routes[k].ipaddr, k + 2);
+    routes[k].length = 128;
+    routes[k].next = head;
+    head = &routes[k];
+    if(!route_index_add(&routes[k].ipaddr[8], &routes[k])) {
+      fprintf(stderr, "route-bench: index full at %d routes\n", k);
+      exit(1);
+    }
+  }
+  for(k = 0; k < 2 * n; k++) {
+    /* Even: routed nodes in random order, odd: unknown nodes */
+    node_addr(addrs[k], k % 2 ? n + 2 + k : 2 + rand() % n);
+  }
+
+  t0 = now_ns();
+  for(i = 0; i < lookups; i++) {
+    sink = list_lookup(addrs[i % (2 * n)]);
+  }
+  t_list = (now_ns() - t0) / lookups;
+
+  t0 = now_ns();
+  for(i = 0; i < lookups; i++) {
+    r = route_index_lookup(&addrs[i % (2 * n)][8]);
+    if(r == NULL) {
+      miss++;
+    }
+    sink = r;
+  }
+  t_index = (now_ns() - t0) / lookups;
+  (void)sink;
+
+  printf("%4d routes: list %8.1f ns  index %6.1f ns  (%.0fx)  "
+         "list %zu B  index %zu B\n", n, t_list, t_index, t_list / t_index,
+         n * sizeof(struct route),
+         (size_t)ROUTE_INDEX_SIZE * (ROUTE_INDEX_IID_LEN + sizeof(void *)));
+  if(miss != lookups / 2) {
+    fprintf(stderr, "route-bench: %ld misses, expected %ld\n", miss, lookups / 2);
+    exit(1);
+  }
+  free(routes);
+  free(addrs);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static const int sizes[] = { 50, 200, 500 };
+  long lookups = 1000000;
+  int c, i;
+
+  while((c = getopt(argc, argv, "l:")) != -1) {
+    if(c == 'l') {
+      lookups = strtol(optarg, NULL, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-l lookups] [routes ...]\n", argv[0]);
+      return 1;
+    }
+  }
+  srand(1);
+  if(optind == argc) {
+    for(i = 0; i < 3; i++) {
+      run(sizes[i], lookups);
+    }
+  }
+  for(i = optind; i < argc; i++) {
+    run(atoi(argv[i]), lookups);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
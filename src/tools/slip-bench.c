@@ -0,0 +1,285 @@
+/*
+ * Loopback throughput benchmark for the SLIP framing used between the
+ * border router and the host tunnel.
+ *
+ * A child process plays the border router on the slave side of a pty:
+ * it decodes every frame and echoes it back, writing all frames decoded
+ * from one read in a single burst as slip-bridge.c does. The parent
+ * sends packets in batches of -b frames per write() and measures
+ * packets per second and round trip latency.
+ *
+ * A pty has no baud rate, so this measures framing and syscall cost,
+ * i.e. how much host CPU the tunnel needs per packet, not UART speed.
+ *
+ *   slip-bench [-n packets] [-s size] [-b batch] [-w window] [-c]
+ */
+
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slip-frame.h"
+
+static int crc;
+static int fd_echo;
+static uint8_t echo_out[64 * 1024];
+static size_t echo_len;
+
+static unsigned long received;
+static unsigned long bad_payload;
+static double *send_time;
+static double *latency;
+static unsigned long packets;
+
+/*---------------------------------------------------------------------------*/
+static double
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_raw(int fd)
+{
+  struct termios tty;
+
+  if(tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+write_all(int fd, const uint8_t *data, size_t len)
+{
+  ssize_t n;
+
+  while(len > 0) {
+    n = write(fd, data, len);
+    if(n < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    data += n;
+    len -= n;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Border router side: echo every frame */
+static void
+echo_frame(void *ptr, const uint8_t *data, size_t len)
+{
+  if(echo_len + SLIP_FRAME_MAX(len) > sizeof(echo_out)) {
+    write_all(fd_echo, echo_out, echo_len);
+    echo_len = 0;
+  }
+  echo_len += slip_frame_encode(&echo_out[echo_len], data, len, crc,
+                                echo_len == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_echo(int fd)
+{
+  struct slip_decoder dec;
+  uint8_t in[4096];
+  ssize_t n;
+
+  fd_echo = fd;
+  slip_decoder_init(&dec, crc);
+  while((n = read(fd, in, sizeof(in))) > 0) {
+    echo_len = 0;
+    slip_decoder_input(&dec, in, n, echo_frame, NULL);
+    if(echo_len > 0 && write_all(fd, echo_out, echo_len) < 0) {
+      break;
+    }
+  }
+  _exit(0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill_packet(uint8_t *p, size_t size, uint32_t seq)
+{
+  size_t i;
+
+  memcpy(p, &seq, sizeof(seq));
+  /* Cover all byte values so that escaping is exercised */
+  for(i = sizeof(seq); i < size; i++) {
+    p[i] = (uint8_t)(seq + i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+host_frame(void *ptr, const uint8_t *data, size_t len)
+{
+  size_t size = *(size_t *)ptr;
+  uint8_t expect[SLIP_FRAME_MTU];
+  uint32_t seq;
+
+  if(len != size) {
+    bad_payload++;
+    return;
+  }
+  memcpy(&seq, data, sizeof(seq));
+  fill_packet(expect, size, seq);
+  if(seq >= packets || memcmp(expect, data, len) != 0) {
+    bad_payload++;
+    return;
+  }
+  latency[received++] = now_us() - send_time[seq];
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n packets] [-s size] [-b batch] "
+          "[-w window] [-c]\n", prog);
+  fprintf(stderr, "  -n  number of packets (100000)\n");
+  fprintf(stderr, "  -s  payload size in bytes (80)\n");
+  fprintf(stderr, "  -b  frames per write() (8)\n");
+  fprintf(stderr, "  -w  max packets in flight (64)\n");
+  fprintf(stderr, "  -c  CRC-16 framing\n");
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  size_t size = 80;
+  unsigned long batch = 8, window = 64, sent = 0, i;
+  struct slip_decoder dec;
+  static uint8_t out[64 * SLIP_FRAME_MAX(SLIP_FRAME_MTU)];
+  size_t out_len = 0, out_off = 0;
+  uint8_t pkt[SLIP_FRAME_MTU], in[4096];
+  double start, elapsed, sum = 0;
+  int master, slave, c;
+  pid_t pid;
+
+  packets = 100000;
+  while((c = getopt(argc, argv, "n:s:b:w:c")) != -1) {
+    switch(c) {
+    case 'n': packets = strtoul(optarg, NULL, 0); break;
+    case 's': size = strtoul(optarg, NULL, 0); break;
+    case 'b': batch = strtoul(optarg, NULL, 0); break;
+    case 'w': window = strtoul(optarg, NULL, 0); break;
+    case 'c': crc = 1; break;
+    default: usage(argv[0]);
+    }
+  }
+  if(packets == 0 || size < 4 || size > SLIP_FRAME_MTU ||
+     batch == 0 || batch > 64 || window < batch) {
+    usage(argv[0]);
+  }
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    perror("slip-bench: pty");
+    return 1;
+  }
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if(slave < 0) {
+    perror("slip-bench: pty slave");
+    return 1;
+  }
+  make_raw(master);
+  make_raw(slave);
+
+  pid = fork();
+  if(pid == 0) {
+    close(master);
+    run_echo(slave);
+  }
+  close(slave);
+  fcntl(master, F_SETFL, O_NONBLOCK);
+
+  send_time = calloc(packets, sizeof(double));
+  latency = calloc(packets, sizeof(double));
+  if(send_time == NULL || latency == NULL) {
+    fprintf(stderr, "slip-bench: out of memory\n");
+    return 1;
+  }
+  slip_decoder_init(&dec, crc);
+
+  start = now_us();
+  while(received + bad_payload + dec.crc_errors < packets) {
+    struct pollfd pfd = { master, POLLIN, 0 };
+    ssize_t n;
+
+    /* Queue the next batch when the previous one has been written */
+    if(out_off == out_len && sent < packets &&
+       sent - received <= window - batch) {
+      out_len = out_off = 0;
+      for(i = 0; i < batch && sent < packets; i++, sent++) {
+        fill_packet(pkt, size, sent);
+        send_time[sent] = now_us();
+        out_len += slip_frame_encode(&out[out_len], pkt, size, crc, i == 0);
+      }
+    }
+    if(out_off < out_len) {
+      pfd.events |= POLLOUT;
+    }
+    if(poll(&pfd, 1, 2000) <= 0) {
+      fprintf(stderr, "slip-bench: timeout, %lu of %lu packets back\n",
+              received, packets);
+      break;
+    }
+    if(pfd.revents & POLLOUT) {
+      n = write(master, &out[out_off], out_len - out_off);
+      if(n > 0) {
+        out_off += n;
+      }
+    }
+    if(pfd.revents & POLLIN) {
+      n = read(master, in, sizeof(in));
+      if(n > 0) {
+        slip_decoder_input(&dec, in, n, host_frame, &size);
+      }
+    }
+  }
+  elapsed = now_us() - start;
+
+  kill(pid, SIGTERM);
+  waitpid(pid, NULL, 0);
+
+  for(i = 0; i < received; i++) {
+    sum += latency[i];
+  }
+  qsort(latency, received, sizeof(double), cmp_double);
+
+  printf("slip-bench: %lu packets x %zu bytes, batch %lu, window %lu, crc %s\n",
+         packets, size, batch, window, crc ? "on" : "off");
+  printf("  received %lu, bad payload %lu, crc errors %lu\n",
+         received, bad_payload, dec.crc_errors);
+  if(received > 0) {
+    printf("  throughput %.0f packets/s, %.2f MB/s payload\n",
+           received / (elapsed / 1e6), received * size / elapsed);
+    printf("  round trip avg %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           sum / received, latency[received / 2],
+           latency[(received * 99) / 100], latency[received - 1]);
+  }
+  return received == packets ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
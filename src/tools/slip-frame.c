@@ -0,0 +1,145 @@
+/*
+ * Host side SLIP framing matching the border router's slip-bridge.c.
+ */
+
+#include "slip-frame.h"
+
+/*---------------------------------------------------------------------------*/
+/* Same CRC as Contiki's lib/crc16.c */
+uint16_t
+slip_crc16_add(uint8_t b, uint16_t acc)
+{
+  acc ^= b;
+  acc = (acc >> 8) | (acc << 8);
+  acc ^= (acc & 0xff00) << 4;
+  acc ^= (acc >> 8) >> 4;
+  acc ^= (acc & 0xff00) >> 5;
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+slip_crc16_data(const uint8_t *data, size_t len, uint16_t acc)
+{
+  size_t i;
+
+  for(i = 0; i < len; i++) {
+    acc = slip_crc16_add(data[i], acc);
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_escaped(uint8_t *p, uint8_t c)
+{
+  if(c == SLIP_END) {
+    *p++ = SLIP_ESC;
+    *p++ = SLIP_ESC_END;
+  } else if(c == SLIP_ESC) {
+    *p++ = SLIP_ESC;
+    *p++ = SLIP_ESC_ESC;
+  } else {
+    *p++ = c;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+size_t
+slip_frame_encode(uint8_t *out, const uint8_t *data, size_t len,
+                  int crc, int lead)
+{
+  uint8_t *p = out;
+  size_t i;
+
+  if(lead) {
+    *p++ = SLIP_END;
+  }
+  for(i = 0; i < len; i++) {
+    p = put_escaped(p, data[i]);
+  }
+  if(crc) {
+    uint16_t c = slip_crc16_data(data, len, 0);
+    p = put_escaped(p, c & 0xff);
+    p = put_escaped(p, c >> 8);
+  }
+  *p++ = SLIP_END;
+  return p - out;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_decoder_init(struct slip_decoder *d, int crc)
+{
+  d->len = 0;
+  d->esc = 0;
+  d->overflow = 0;
+  d->crc = crc;
+  d->frames = 0;
+  d->crc_errors = 0;
+  d->overflows = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+frame_done(struct slip_decoder *d,
+           void (*frame)(void *ptr, const uint8_t *data, size_t len),
+           void *ptr)
+{
+  size_t len = d->len;
+
+  d->len = 0;
+  d->esc = 0;
+  if(d->overflow) {
+    d->overflow = 0;
+    d->overflows++;
+    return 0;
+  }
+  if(len == 0) {
+    return 0;
+  }
+  if(d->crc) {
+    if(len < 2 ||
+       slip_crc16_data(d->buf, len - 2, 0) !=
+       (d->buf[len - 2] | (d->buf[len - 1] << 8))) {
+      d->crc_errors++;
+      return 0;
+    }
+    len -= 2;
+  }
+  d->frames++;
+  frame(ptr, d->buf, len);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_decoder_input(struct slip_decoder *d, const uint8_t *data, size_t len,
+                   void (*frame)(void *ptr, const uint8_t *data, size_t len),
+                   void *ptr)
+{
+  int n = 0;
+  size_t i;
+  uint8_t c;
+
+  for(i = 0; i < len; i++) {
+    c = data[i];
+    if(c == SLIP_END) {
+      n += frame_done(d, frame, ptr);
+      continue;
+    }
+    if(d->esc) {
+      d->esc = 0;
+      if(c == SLIP_ESC_END) {
+        c = SLIP_END;
+      } else if(c == SLIP_ESC_ESC) {
+        c = SLIP_ESC;
+      }
+    } else if(c == SLIP_ESC) {
+      d->esc = 1;
+      continue;
+    }
+    if(d->len < sizeof(d->buf)) {
+      d->buf[d->len++] = c;
+    } else {
+      d->overflow = 1;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,59 @@
+/*
+ * Host side SLIP framing matching the border router's slip-bridge.c.
+ *
+ * Frames are RFC 1055 SLIP. With CRC enabled every frame carries a
+ * trailing CRC-16 computed like Contiki's lib/crc16.c, low byte first.
+ */
+
+#ifndef SLIP_FRAME_H_
+#define SLIP_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+/* Worst case encoded size of a len byte payload */
+#define SLIP_FRAME_MAX(len) (2 * ((len) + 2) + 2)
+
+#ifndef SLIP_FRAME_MTU
+#define SLIP_FRAME_MTU 2048
+#endif
+
+uint16_t slip_crc16_add(uint8_t b, uint16_t acc);
+uint16_t slip_crc16_data(const uint8_t *data, size_t len, uint16_t acc);
+
+/*
+ * Encode one frame into out, which must hold SLIP_FRAME_MAX(len) bytes.
+ * If lead is zero the leading END is left out, which is allowed when the
+ * previous frame in the same write just ended. Returns the encoded size.
+ */
+size_t slip_frame_encode(uint8_t *out, const uint8_t *data, size_t len,
+                         int crc, int lead);
+
+struct slip_decoder {
+  uint8_t buf[SLIP_FRAME_MTU + 2];
+  size_t len;
+  int esc;
+  int overflow;
+  int crc;
+  unsigned long frames;
+  unsigned long crc_errors;
+  unsigned long overflows;
+};
+
+void slip_decoder_init(struct slip_decoder *d, int crc);
+
+/*
+ * Feed received bytes to the decoder. frame is called once for each
+ * complete, non-empty frame that passed the CRC check, with the CRC
+ * already stripped. Returns the number of frames delivered.
+ */
+int slip_decoder_input(struct slip_decoder *d, const uint8_t *data, size_t len,
+                       void (*frame)(void *ptr, const uint8_t *data, size_t len),
+                       void *ptr);
+
+#endif /* SLIP_FRAME_H_ */
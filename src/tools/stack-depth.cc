@@ -0,0 +1,733 @@
+/*
+ * Worst case stack depth of an msp430 firmware image, from its code and
+ * call graph:
+ *
+ *   stack-depth [-s obj_dir]... [-i hops] [-n top] [-S min_free] image.sky
+ *
+ * The frame of each function, including the arguments it pushes for its
+ * calls, is read from its machine code. With -s, the .su files that gcc
+ * writes with -fstack-usage in that directory (make STACK_USAGE=1, see
+ * src/apps/stack-probe) give frames too, the larger of the two is used.
+ *
+ * Calls through function pointers (processes, callbacks) may go to any
+ * function whose address the program takes. The entry points are main,
+ * the processes, the functions called through pointers and the
+ * interrupt handlers; for each the worst stack depth is printed with the
+ * calls that reach it. A path is followed through at most -i (default
+ * 4) pointer calls; the entry points with paths cut there are listed,
+ * and their depths are estimates rather than bounds.
+ *
+ * The worst case for the program is the deepest of main and of every
+ * entry point main reaches, the latter on top of the stack main uses
+ * where it calls through a pointer, plus the deepest interrupt handler,
+ * as handlers do not nest. It is compared with the RAM between the end
+ * of .bss/.noinit and the top of the stack.
+ *
+ * Recursion is broken at the first repeated function and reported. The
+ * exit status is 1 if the worst case does not fit, or leaves less than
+ * -S bytes free.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+
+struct call {
+  uint32_t target;              /* 0 if through a pointer */
+  int offset;                   /* stack in use by the caller at the call */
+  int ret;                      /* return address bytes, 0 for a jump */
+};
+
+struct function {
+  string name;
+  uint32_t addr = 0, size = 0;
+  int frame = 0;                /* deepest stack of its own code */
+  int su = -1;                  /* frame from the .su file */
+  bool su_dynamic = false;
+  vector<call> calls;
+};
+
+/* Worst depth of a function with a number of pointer calls left, and
+   the call that reaches it */
+struct result {
+  int depth = 0, state = 0;
+  bool capped = false;          /* a pointer call was not followed */
+  string path;
+};
+
+static vector<uint8_t> image;
+static std::map<uint32_t, function> functions;
+static std::set<uint32_t> taken;
+static std::set<string> recursion;
+static std::set<uint32_t> on_path;
+static std::map<std::pair<uint32_t, int>, result> results;
+static vector<uint32_t> pointer_targets, threads;
+static int indirect_jumps, max_hops = 4;
+
+struct section {
+  string name;
+  uint32_t addr, offset, size, flags;
+};
+static vector<section> sections;
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+u32(size_t off)
+{
+  return off + 4 > image.size() ? 0 : image[off] | image[off + 1] << 8 |
+    image[off + 2] << 16 | (uint32_t)image[off + 3] << 24;
+}
+static uint16_t
+u16(size_t off)
+{
+  return off + 2 > image.size() ? 0 : image[off] | image[off + 1] << 8;
+}
+static string
+str(size_t off)
+{
+  return off < image.size() ? string((const char *)&image[off],
+                                     strnlen((const char *)&image[off], image.size() - off)) : "";
+}
+/*---------------------------------------------------------------------------*/
+/* Word at a target address, from the section that holds it */
+static bool
+word_at(uint32_t addr, uint16_t *w)
+{
+  for(auto &s : sections) {
+    if(s.flags & 0x2 && addr >= s.addr && addr + 2 <= s.addr + s.size) {
+      *w = u16(s.offset + addr - s.addr);
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+read_image(const char *path, uint32_t *ram_end, uint32_t *stack_top)
+{
+  FILE *f = fopen(path, "rb");
+  uint32_t shoff, strtab, i;
+  uint16_t shentsize, shnum, shstrndx;
+  std::map<uint32_t, std::pair<string, uint32_t>> syms;
+
+  if(f == NULL) {
+    perror(path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  image.resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  if(fread(image.data(), 1, image.size(), f) != image.size() ||
+     memcmp(image.data(), "\x7f" "ELF", 4) != 0 || image[4] != 1) {
+    fprintf(stderr, "%s: not an ELF32 image\n", path);
+    fclose(f);
+    return false;
+  }
+  fclose(f);
+
+  shoff = u32(32);
+  shentsize = u16(46);
+  shnum = u16(48);
+  shstrndx = u16(50);
+  strtab = u32(shoff + shstrndx * shentsize + 16);
+  for(i = 0; i < shnum; i++) {
+    size_t sh = shoff + i * shentsize;
+    sections.push_back({ str(strtab + u32(sh)), u32(sh + 12), u32(sh + 16),
+                         u32(sh + 20), u32(sh + 8) });
+    /* SHT_NOBITS has no data in the file */
+    if(u32(sh + 4) == 8) {
+      sections.back().flags &= ~0x4u;
+      sections.back().offset = 0;
+    }
+  }
+
+  *ram_end = 0;
+  *stack_top = 0;
+  for(auto &s : sections) {
+    if(s.name == ".data" || s.name == ".bss" || s.name == ".noinit") {
+      *ram_end = std::max(*ram_end, s.addr + s.size);
+    }
+  }
+
+  for(i = 0; i < shnum; i++) {
+    size_t sh = shoff + i * shentsize;
+    if(u32(sh + 4) != 2) {      /* SHT_SYMTAB */
+      continue;
+    }
+    uint32_t symoff = u32(sh + 16), symsize = u32(sh + 20);
+    uint32_t names = sections[u32(sh + 24)].offset;
+    for(uint32_t s = 16; s + 16 <= symsize; s += 16) {
+      string name = str(names + u32(symoff + s));
+      uint32_t value = u32(symoff + s + 4), size = u32(symoff + s + 8);
+      uint8_t type = image[symoff + s + 12] & 0x0f;
+      uint16_t shndx = u16(symoff + s + 14);
+
+      if(name == "__stack") {
+        *stack_top = value;
+      } else if(name == "_end" && value > *ram_end) {
+        *ram_end = value;
+      }
+      /* Functions, and labels of assembler code */
+      if(shndx == 0 || shndx >= sections.size() || !(sections[shndx].flags & 0x4) ||
+         (type != 0 && type != 2) || name.empty() || name[0] == '.' || name[0] == '$') {
+        continue;
+      }
+      auto old = syms.find(value);
+      if(old == syms.end() || (type == 2 && old->second.second == 0)) {
+        syms[value] = { name, type == 2 ? size : 0 };
+      }
+    }
+  }
+
+  /* Labels without a size end at the next one */
+  for(auto it = syms.begin(); it != syms.end(); ++it) {
+    auto next = std::next(it);
+    function fn;
+    fn.name = it->second.first;
+    fn.addr = it->first;
+    fn.size = it->second.second;
+    if(fn.size == 0 && next != syms.end()) {
+      fn.size = next->first - fn.addr;
+    }
+    functions[fn.addr] = fn;
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static function *
+function_at(uint32_t addr)
+{
+  auto it = functions.find(addr);
+  return it == functions.end() ? NULL : &it->second;
+}
+/*---------------------------------------------------------------------------*/
+/* Length in bytes of the extra word of a source operand */
+static int
+src_ext(int as, int reg)
+{
+  return (as == 1 && reg != 3) || (as == 3 && reg == 0) ? 2 : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Read the frame and the calls of fn from its machine code. The stack
+   in use is followed through the code in address order; after a
+   return or jump it continues with what was in use at the jump to the
+   next instruction, if there is one. */
+static void
+analyse(function &fn)
+{
+  std::map<uint32_t, int> at_target;
+  uint32_t pc = fn.addr, end = fn.addr + fn.size;
+  int off = 0;
+  bool flow_ends = false;
+
+  while(pc + 2 <= end) {
+    uint16_t w, x = 0;
+    int len = 2;
+
+    if(flow_ends) {
+      /* Nothing jumps past here: the end of the code of a label
+         without a size */
+      auto t = at_target.lower_bound(pc);
+      if(t == at_target.end()) {
+        break;
+      }
+      if(t->first == pc) {
+        off = t->second;
+      }
+      flow_ends = false;
+    }
+    if(!word_at(pc, &w)) {
+      break;
+    }
+    word_at(pc + 2, &x);
+
+    if(w >= 0x1800 && w < 0x2000) {
+      /* MSP430X extension word of the next instruction */
+      pc += 2;
+      continue;
+    } else if(w < 0x1000) {
+      /* MSP430X address instructions */
+      int kind = (w >> 4) & 0xf, dst = w & 0xf;
+      len = (kind >= 2 && kind <= 3) || (kind >= 6 && kind <= 11) ? 4 : 2;
+      if(dst == 1 && (kind == 0xa || kind == 0xb)) {
+        int imm = ((w >> 8) & 0xf) << 16 | x;
+        off += kind == 0xb ? imm : -imm;
+      }
+    } else if(w >= 0x1300 && w < 0x1400) {
+      /* CALLA and RETA */
+      int kind = (w >> 4) & 0xf;
+      if(w == 0x1300) {
+        flow_ends = true;
+      } else {
+        len = kind == 5 || kind == 8 || kind == 9 || kind == 0xb ? 4 : 2;
+        fn.calls.push_back({ kind == 0xb ? (uint32_t)((w & 0xf) << 16 | x) : 0, off, 4 });
+      }
+    } else if(w >= 0x1400 && w < 0x1800) {
+      /* PUSHM and POPM, .A pushes 4 bytes a register */
+      int n = ((w >> 4) & 0xf) + 1, bytes = w < 0x1500 || (w >= 0x1600 && w < 0x1700) ? 4 : 2;
+      off += w < 0x1600 ? n * bytes : -n * bytes;
+    } else if(w < 0x2000) {
+      /* Single operand instructions */
+      int op = (w >> 7) & 7, as = (w >> 4) & 3, reg = w & 0xf;
+      len = 2 + src_ext(as, reg);
+      if(op == 4) {                     /* PUSH */
+        off += 2;
+        if(as == 3 && reg == 0) {
+          taken.insert(x);
+        }
+      } else if(op == 5) {              /* CALL */
+        fn.calls.push_back({ as == 3 && reg == 0 ? x : 0u, off, 2 });
+      } else if(op == 6) {              /* RETI */
+        flow_ends = true;
+      }
+    } else if(w < 0x4000) {
+      /* Jumps */
+      int cond = (w >> 10) & 7, rel = w & 0x3ff;
+      uint32_t target = pc + 2 + 2 * (rel >= 0x200 ? rel - 0x400 : rel);
+      if(target < fn.addr || target >= end) {
+        fn.calls.push_back({ target, off, 0 });
+      } else if(at_target.count(target) == 0 || at_target[target] < off) {
+        at_target[target] = off;
+      }
+      flow_ends = cond == 7;
+    } else {
+      /* Two operand instructions */
+      int op = w >> 12, src = (w >> 8) & 0xf, ad = (w >> 7) & 1;
+      int as = (w >> 4) & 3, dst = w & 0xf;
+      bool imm = as == 3 && src == 0;
+      int value = imm ? (int16_t)x : src == 2 && as >= 2 ? (as == 2 ? 4 : 8) :
+        src == 3 ? (as == 3 ? -1 : as) : 0;
+      bool constant = imm || (src == 2 && as >= 2) || src == 3;
+
+      len = 2 + src_ext(as, src) + (ad ? 2 : 0);
+      if(dst == 1 && ad == 0 && constant && op == 8) {          /* SUB #n, r1 */
+        off += value;
+      } else if(dst == 1 && ad == 0 && constant && op == 5) {   /* ADD #n, r1 */
+        off -= value;
+      } else if(op == 4 && src == 1 && as == 3) {               /* POP */
+        off -= 2;
+      }
+      if(op == 4 && dst == 0 && ad == 0) {
+        /* A move to the PC: return, branch or jump through a table */
+        if(src == 1 && as == 3) {
+          /* RET */
+        } else if(imm) {
+          if(x < fn.addr || x >= end) {
+            fn.calls.push_back({ x, off, 0 });
+          } else if(at_target.count(x) == 0 || at_target[x] < off) {
+            at_target[x] = off;
+          }
+        } else if(as == 1 && src != 2 && src != 3) {
+          /* x(Rn): a table of addresses within the function */
+          indirect_jumps++;
+        } else {
+          fn.calls.push_back({ 0, off, 0 });
+        }
+        flow_ends = true;
+      } else if(imm) {
+        taken.insert(x);
+      }
+    }
+    fn.frame = std::max(fn.frame, off);
+    pc += len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Function addresses stored in data: process structures, tables of
+   callbacks */
+static void
+scan_data(void)
+{
+  for(auto &s : sections) {
+    if(!(s.flags & 0x2) || s.flags & 0x4 || s.offset == 0 || s.name == ".vectors") {
+      continue;
+    }
+    for(uint32_t i = 0; i + 2 <= s.size; i += 2) {
+      taken.insert(u16(s.offset + i));
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Contiki runs the process threads from these two only */
+static bool
+calls_threads(const function &fn)
+{
+  return fn.name == "call_process" || fn.name == "exit_process";
+}
+/*---------------------------------------------------------------------------*/
+static result &
+depth(function &fn, int hops)
+{
+  result &r = results[{ fn.addr, hops }];
+
+  if(r.state == 2) {
+    return r;
+  }
+  if(r.state == 1 || on_path.count(fn.addr) != 0) {
+    recursion.insert(fn.name);
+    return r;
+  }
+  r.state = 1;
+  on_path.insert(fn.addr);
+  r.depth = fn.frame;
+  r.path = fn.name;
+  for(auto &c : fn.calls) {
+    if(c.target != 0) {
+      function *callee = function_at(c.target);
+      if(callee != NULL) {
+        result &cr = depth(*callee, hops);
+        int d = c.offset + c.ret + cr.depth;
+        r.capped |= cr.capped;
+        if(d > r.depth) {
+          r.depth = d;
+          r.path = fn.name + " > " + cr.path;
+        }
+      }
+      continue;
+    }
+    if(hops == 0) {
+      r.capped = true;
+      continue;
+    }
+    for(uint32_t t : calls_threads(fn) ? threads : pointer_targets) {
+      function &callee = functions[t];
+      if(on_path.count(t) != 0) {
+        continue;
+      }
+      result &cr = depth(callee, hops - 1);
+      int d = c.offset + c.ret + cr.depth;
+      r.capped |= cr.capped;
+      if(d > r.depth) {
+        r.depth = d;
+        r.path = fn.name + " *> " + cr.path;
+      }
+    }
+  }
+  r.state = 2;
+  on_path.erase(fn.addr);
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+/* Deepest stack in use at a call through a pointer, following direct
+   calls only: what the functions called through pointers run on top
+   of, at the least */
+static int
+dispatch_depth(const function &fn, std::map<uint32_t, int> &memo)
+{
+  auto m = memo.find(fn.addr);
+  if(m != memo.end()) {
+    return m->second;
+  }
+  int &d = memo[fn.addr];
+  d = 0;
+  for(auto &c : fn.calls) {
+    if(c.target == 0) {
+      d = std::max(d, c.offset + c.ret);
+    } else if(function *callee = function_at(c.target)) {
+      int cd = dispatch_depth(*callee, memo);
+      if(cd > 0) {
+        d = std::max(d, c.offset + c.ret + cd);
+      }
+    }
+  }
+  return d;
+}
+/*---------------------------------------------------------------------------*/
+/* Functions that fn can reach, through pointers too */
+static void
+reach(const function &fn, std::set<uint32_t> &seen)
+{
+  if(!seen.insert(fn.addr).second) {
+    return;
+  }
+  for(auto &c : fn.calls) {
+    if(c.target != 0) {
+      if(function *callee = function_at(c.target)) {
+        reach(*callee, seen);
+      }
+      continue;
+    }
+    for(uint32_t t : calls_threads(fn) ? threads : pointer_targets) {
+      reach(functions[t], seen);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The calls to the worst depth, up to a function that is already on
+   it (the depth of a function is kept from the first path it was
+   reached on) */
+static string
+path(const function &fn, int hops)
+{
+  const string &p = results[{ fn.addr, hops }].path;
+  std::set<string> seen;
+  size_t start = 0, end;
+
+  do {
+    end = p.find(' ', start);
+    string name = p.substr(start, end - start);
+    if(!seen.insert(name).second) {
+      return p.substr(0, start) + "...";
+    }
+    start = p.find(' ', end + 1);
+    start = start == string::npos ? start : start + 1;
+  } while(end != string::npos && start != string::npos);
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* "file.c:12:6:name  24  static" lines of gcc -fstack-usage */
+static void
+read_su(const string &dir)
+{
+  DIR *d = opendir(dir.c_str());
+  struct dirent *e;
+  std::map<string, std::pair<int, bool>> su;
+
+  if(d == NULL) {
+    perror(dir.c_str());
+    return;
+  }
+  while((e = readdir(d)) != NULL) {
+    string name = e->d_name;
+    if(name.size() < 4 || name.compare(name.size() - 3, 3, ".su") != 0) {
+      continue;
+    }
+    FILE *f = fopen((dir + "/" + name).c_str(), "r");
+    char line[512], fname[256], kind[64];
+    int size;
+    while(f != NULL && fgets(line, sizeof(line), f) != NULL) {
+      char *colon = strrchr(strtok(line, "\t"), ':');
+      char *rest = strtok(NULL, "");
+      if(colon == NULL || rest == NULL ||
+         sscanf(colon + 1, "%255s", fname) != 1 ||
+         sscanf(rest, "%d %63s", &size, kind) != 2) {
+        continue;
+      }
+      auto &s = su[fname];
+      s.first = std::max(s.first, size);
+      s.second |= strncmp(kind, "dynamic", 7) == 0 && strstr(kind, "bounded") == NULL;
+    }
+    if(f != NULL) {
+      fclose(f);
+    }
+  }
+  closedir(d);
+
+  for(auto &fn : functions) {
+    auto s = su.find(fn.second.name);
+    if(s != su.end()) {
+      /* A larger frame than the code shows moves its calls down too */
+      int more = s->second.first - fn.second.frame;
+      fn.second.su = s->second.first;
+      fn.second.su_dynamic = s->second.second;
+      if(more > 0) {
+        fn.second.frame += more;
+        for(auto &c : fn.second.calls) {
+          c.offset += more;
+        }
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  vector<string> su_dirs;
+  int top = 20, min_free = 0, opt;
+  uint32_t ram_end, stack_top;
+
+  while((opt = getopt(argc, argv, "s:n:S:i:")) != -1) {
+    switch(opt) {
+    case 's': su_dirs.push_back(optarg); break;
+    case 'n': top = atoi(optarg); break;
+    case 'S': min_free = atoi(optarg); break;
+    case 'i': max_hops = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: stack-depth [-s obj_dir]... [-i hops] [-n top] [-S min_free] image\n");
+      return 2;
+    }
+  }
+  if(optind + 1 != argc) {
+    fprintf(stderr, "usage: stack-depth [-s obj_dir]... [-i hops] [-n top] [-S min_free] image\n");
+    return 2;
+  }
+  if(!read_image(argv[optind], &ram_end, &stack_top)) {
+    return 2;
+  }
+
+  for(auto &fn : functions) {
+    analyse(fn.second);
+  }
+  scan_data();
+  for(auto &dir : su_dirs) {
+    read_su(dir);
+  }
+
+  /* Interrupt handlers from the vector table, all but reset */
+  std::set<uint32_t> handlers;
+  for(auto &s : sections) {
+    if(s.name == ".vectors" && s.offset != 0) {
+      for(uint32_t i = 0; i + 4 <= s.size; i += 2) {
+        uint32_t v = u16(s.offset + i);
+        if(function_at(v) != NULL) {
+          handlers.insert(v);
+        }
+      }
+    }
+  }
+  for(uint32_t t : taken) {
+    function *f = function_at(t);
+    if(f == NULL || handlers.count(t) != 0) {
+      continue;
+    }
+    if(f->name.compare(0, 15, "process_thread_") == 0) {
+      threads.push_back(t);
+    } else {
+      pointer_targets.push_back(t);
+    }
+  }
+
+  /* Entry points: main, processes, functions called through pointers */
+  vector<function *> entries;
+  for(auto &fn : functions) {
+    function &f = fn.second;
+    if(f.name == "main" || f.name.compare(0, 15, "process_thread_") == 0 ||
+       taken.count(f.addr) != 0) {
+      entries.push_back(&f);
+    }
+  }
+  for(auto *f : entries) {
+    depth(*f, 0);
+    depth(*f, max_hops);
+  }
+  for(uint32_t h : handlers) {
+    depth(functions[h], max_hops);
+  }
+  auto depth_of = [](const function *f) { return results[{ f->addr, max_hops }].depth; };
+  std::sort(entries.begin(), entries.end(), [&](const function *a, const function *b) {
+      return depth_of(a) != depth_of(b) ? depth_of(a) > depth_of(b) : a->name < b->name;
+    });
+
+  function *main_fn = NULL, *worst_irq = NULL;
+  for(auto &fn : functions) {
+    if(fn.second.name == "main") {
+      main_fn = &fn.second;
+    }
+  }
+  for(uint32_t h : handlers) {
+    if(worst_irq == NULL || depth_of(&functions[h]) > depth_of(worst_irq)) {
+      worst_irq = &functions[h];
+    }
+  }
+  int main_depth = main_fn != NULL ? depth_of(main_fn) : 0;
+
+  /* The entry points main reaches run nested under it. The path from
+     main may have been cut at -i pointer calls before it got to one of
+     them, so each also counts on top of the stack main is using where
+     it calls through a pointer. */
+  std::set<uint32_t> reachable;
+  std::map<uint32_t, int> dispatch_memo;
+  int dispatch = 0, thread_depth = main_depth;
+  function *thread_worst = main_fn;
+  if(main_fn != NULL) {
+    reach(*main_fn, reachable);
+    dispatch = dispatch_depth(*main_fn, dispatch_memo);
+  }
+  for(auto *f : entries) {
+    if(f != main_fn && reachable.count(f->addr) != 0 &&
+       dispatch + depth_of(f) > thread_depth) {
+      thread_depth = dispatch + depth_of(f);
+      thread_worst = f;
+    }
+  }
+
+  /* An interrupt pushes the PC and SR before its handler runs */
+  int irq_depth = worst_irq != NULL ? depth_of(worst_irq) + 4 : 0;
+  int worst = thread_depth + irq_depth;
+  int room = stack_top > ram_end ? stack_top - ram_end : 0;
+
+  printf("%s: stack 0x%04x-0x%04x, %d bytes\n", argv[optind], ram_end, stack_top, room);
+  if(thread_worst == main_fn) {
+    printf("  worst case %d bytes: main %d + interrupt %d, %d bytes free\n",
+           worst, main_depth, irq_depth, room - worst);
+  } else {
+    printf("  worst case %d bytes: %s %d under main's dispatch %d + interrupt %d,"
+           " %d bytes free\n", worst, thread_worst->name.c_str(), depth_of(thread_worst),
+           dispatch, irq_depth, room - worst);
+  }
+  printf("\n  %6s %6s %6s %6s  %s\n", "worst", "own", "frame", "su",
+         "entry point and its deepest calls");
+  for(size_t i = 0; i < entries.size() && (top <= 0 || (int)i < top); i++) {
+    function *f = entries[i];
+    printf("  %6d %6d %6d %6s  %s\n", depth_of(f), results[{ f->addr, 0 }].depth, f->frame,
+           f->su < 0 ? "-" : (std::to_string(f->su) + (f->su_dynamic ? "+" : "")).c_str(),
+           path(*f, max_hops).c_str());
+  }
+  printf("\n  %6s %6s %6s %6s  %s\n", "worst", "", "frame", "su", "interrupt handlers");
+  for(uint32_t h : handlers) {
+    function &f = functions[h];
+    printf("  %6d %6s %6d %6s  %s\n", depth_of(&f) + 4, "", f.frame,
+           f.su < 0 ? "-" : std::to_string(f.su).c_str(), path(f, max_hops).c_str());
+  }
+
+  printf("\n  %zu functions, %zu processes and %zu other functions called through\n"
+         "  pointers (\"*>\" above, at most %d on a path)", functions.size(),
+         threads.size(), pointer_targets.size(), max_hops);
+  if(indirect_jumps > 0) {
+    printf(", %d jump tables", indirect_jumps);
+  }
+  printf("\n");
+  for(auto &fn : functions) {
+    if(fn.second.su_dynamic) {
+      printf("  WARNING %s has a frame of dynamic size, counted as %d\n",
+             fn.second.name.c_str(), fn.second.frame);
+    }
+  }
+  vector<string> capped;
+  for(auto *f : entries) {
+    if(results[{ f->addr, max_hops }].capped) {
+      capped.push_back(f->name);
+    }
+  }
+  for(uint32_t h : handlers) {
+    if(results[{ h, max_hops }].capped) {
+      capped.push_back(functions[h].name);
+    }
+  }
+  if(!capped.empty()) {
+    printf("  WARNING paths through more than %d pointer calls were cut, so the\n"
+           "  depths of %zu entry points are estimates, not bounds (raise -i):",
+           max_hops, capped.size());
+    for(size_t i = 0; i < capped.size() && i < 8; i++) {
+      printf(" %s", capped[i].c_str());
+    }
+    printf("%s\n", capped.size() > 8 ? " ..." : "");
+  }
+  if(!recursion.empty()) {
+    printf("  WARNING recursion, counted once:");
+    for(auto &r : recursion) {
+      printf(" %s", r.c_str());
+    }
+    printf("\n");
+  }
+  if(worst > room || room - worst < min_free) {
+    printf("STACK worst case %d bytes leaves %d free, %d required\n",
+           worst, room - worst, min_free);
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,63 @@
+# Merges the metrics of a sweep over the seeds, see cooja-sweep.
+# Input: runs.tsv (variant, seed, metric, value). Output: CSV with one
+# column per swept parameter, then metric, runs, mean, standard
+# deviation and the half width of the 95% confidence interval of the
+# mean (Student t).
+# Usage: awk -f sweep-merge.awk runs.tsv > results.csv
+
+BEGIN {
+  FS = "\t"
+  split("12.706 4.303 3.182 2.776 2.571 2.447 2.365 2.306 2.262 2.228 " \
+        "2.201 2.179 2.160 2.145 2.131 2.120 2.110 2.101 2.093 2.086 " \
+        "2.080 2.074 2.069 2.064 2.060 2.056 2.052 2.048 2.045 2.042", t, " ")
+}
+
+NR == 1 {
+  next
+}
+
+{
+  key = $1 SUBSEP $3
+  if(!(key in n)) {
+    keys[++nkeys] = key
+    variant[nkeys] = $1
+    metric[nkeys] = $3
+  }
+  value[key, ++n[key]] = $4
+}
+
+END {
+  # Parameter names, from the first variant
+  np = split(variant[1], first, " ")
+  for(i = 1; i <= np; i++) {
+    split(first[i], kv, "=")
+    printf "%s,", kv[1]
+  }
+  print "metric,runs,mean,sd,ci95"
+
+  for(k = 1; k <= nkeys; k++) {
+    key = keys[k]
+    np = split(variant[k], params, " ")
+    for(i = 1; i <= np; i++) {
+      printf "%s,", substr(params[i], index(params[i], "=") + 1)
+    }
+    sum = 0
+    for(i = 1; i <= n[key]; i++) {
+      sum += value[key, i]
+    }
+    mean = sum / n[key]
+    if(n[key] < 2) {
+      printf "%s,%d,%.6g,,\n", metric[k], n[key], mean
+      continue
+    }
+    sq = 0
+    for(i = 1; i <= n[key]; i++) {
+      sq += (value[key, i] - mean) ^ 2
+    }
+    df = n[key] - 1
+    sd = sqrt(sq / df)
+    q = df <= 30 ? t[df] : 1.96 + 2.4 / df
+    printf "%s,%d,%.6g,%.6g,%.6g\n", metric[k], n[key], mean, sd,
+      q * sd / sqrt(n[key])
+  }
+}
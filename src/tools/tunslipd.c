@@ -0,0 +1,630 @@
+/*
+ * Event driven tunnel daemon between a Linux TUN device and the border
+ * router's SLIP link, serial or Cooja's serial socket. Drop-in for
+ * tunslip6 with the same control messages:
+ *
+ *   ?P from the router   answered with !P and the 64-bit prefix
+ *   !M from the router   router MAC address, requested with ?M at start
+ *   !S from the router   router traffic counters, polled with ?S
+ *   \r frames            router debug output, copied to stdout
+ *
+ * All descriptors are non-blocking and served from one epoll loop.
+ * Packets read from the TUN device are SLIP encoded straight into an
+ * output ring which is flushed with one writev() per wakeup; SLIP input
+ * is read in large chunks and each decoded frame is written to the TUN
+ * device from the decoder's buffer. Throughput and TUN to SLIP queueing
+ * latency are printed every -i seconds and optionally written as JSON.
+ *
+ *   tunslipd [-s dev] [-B baud] [-H] [-a host] [-p port] [-t tun]
+ *            [-c] [-i sec] [-o file] [-v] prefix
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slip-frame.h"
+
+#define TUN_MTU        1280
+#define RING_SIZE      (256 * 1024)
+#define RING_SLACK     SLIP_FRAME_MAX(TUN_MTU)
+#define TUN_BUDGET     64        /* TUN reads per wakeup */
+#define LAT_FIFO       1024      /* packets tracked for latency */
+
+/* SLIP output ring. Frames are encoded in place at the tail; a frame
+   running past the end spills into the slack area and is folded back
+   to the start, so the hot path never copies a packet twice. */
+static uint8_t ring[RING_SIZE + RING_SLACK];
+static uint64_t ring_head, ring_tail;   /* absolute byte counts */
+
+/* Send time and ring end offset of the last LAT_FIFO packets */
+static struct {
+  uint64_t end;
+  double time;
+} lat_fifo[LAT_FIFO];
+static unsigned lat_in, lat_out;
+
+static struct {
+  unsigned long tun_packets, tun_bytes;     /* TUN -> SLIP */
+  unsigned long slip_packets, slip_bytes;   /* SLIP -> TUN */
+  unsigned long ring_full, tun_drops;
+  unsigned long lat_count;
+  double lat_sum, lat_max;
+} cur, total;
+
+static struct {
+  int valid;
+  uint32_t v[7];
+  uint8_t queuebuf_used, queuebuf_total, debug_used, debug_total;
+  double rtt_us;
+} router;
+
+static int crc, verbose, stats_interval = 10;
+static int tun_fd = -1, slip_fd = -1, epoll_fd = -1;
+static int tun_reading = 1;
+static const char *stats_file;
+static char tun_name[IFNAMSIZ] = "tun0";
+static struct in6_addr prefix;
+static int prefix_len = 64;
+static struct slip_decoder dec;
+static double stats_sent_at;
+
+/*---------------------------------------------------------------------------*/
+static double
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+/*---------------------------------------------------------------------------*/
+static void
+die(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  fprintf(stderr, "tunslipd: ");
+  vfprintf(stderr, fmt, ap);
+  if(errno) {
+    fprintf(stderr, ": %s", strerror(errno));
+  }
+  fprintf(stderr, "\n");
+  va_end(ap);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ssystem(const char *fmt, ...)
+{
+  char cmd[256];
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(cmd, sizeof(cmd), fmt, ap);
+  va_end(ap);
+  if(verbose) {
+    fprintf(stderr, "tunslipd: %s\n", cmd);
+  }
+  if(system(cmd) != 0) {
+    fprintf(stderr, "tunslipd: '%s' failed\n", cmd);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_events(int fd, uint32_t events)
+{
+  struct epoll_event ev = { .events = events, .data.fd = fd };
+
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+ring_used(void)
+{
+  return ring_tail - ring_head;
+}
+/*---------------------------------------------------------------------------*/
+/* Encode one frame into the output ring; the caller checks for space */
+static void
+ring_put_frame(const uint8_t *data, size_t len)
+{
+  size_t tail = ring_tail % RING_SIZE;
+  size_t n;
+
+  n = slip_frame_encode(&ring[tail], data, len, crc, ring_used() == 0);
+  if(tail + n > RING_SIZE) {
+    memcpy(ring, &ring[RING_SIZE], tail + n - RING_SIZE);
+  }
+  ring_tail += n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+ring_flush(void)
+{
+  struct iovec iov[2];
+  size_t head, used;
+  ssize_t n;
+  int iovcnt = 1;
+  double now;
+
+  used = ring_used();
+  if(used == 0) {
+    return;
+  }
+  head = ring_head % RING_SIZE;
+  iov[0].iov_base = &ring[head];
+  if(head + used > RING_SIZE) {
+    iov[0].iov_len = RING_SIZE - head;
+    iov[1].iov_base = ring;
+    iov[1].iov_len = used - iov[0].iov_len;
+    iovcnt = 2;
+  } else {
+    iov[0].iov_len = used;
+  }
+  n = writev(slip_fd, iov, iovcnt);
+  if(n < 0) {
+    if(errno == EAGAIN || errno == EINTR) {
+      return;
+    }
+    die("write to router");
+  }
+  ring_head += n;
+
+  now = now_us();
+  while(lat_out != lat_in && lat_fifo[lat_out % LAT_FIFO].end <= ring_head) {
+    double lat = now - lat_fifo[lat_out % LAT_FIFO].time;
+    cur.lat_sum += lat;
+    cur.lat_count++;
+    if(lat > cur.lat_max) {
+      cur.lat_max = lat;
+    }
+    lat_out++;
+  }
+
+  if(!tun_reading && RING_SIZE - ring_used() > RING_SLACK) {
+    tun_reading = 1;
+    set_events(tun_fd, EPOLLIN);
+  }
+  set_events(slip_fd, ring_used() > 0 ? EPOLLIN | EPOLLOUT : EPOLLIN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_control(const char *msg, const uint8_t *data, size_t len)
+{
+  uint8_t buf[2 + 16];
+
+  memcpy(buf, msg, 2);
+  memcpy(&buf[2], data, len);
+  if(RING_SIZE - ring_used() > RING_SLACK) {
+    ring_put_frame(buf, 2 + len);
+    ring_flush();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tun_input(void)
+{
+  uint8_t pkt[TUN_MTU + 4];
+  ssize_t n;
+  int i;
+
+  for(i = 0; i < TUN_BUDGET; i++) {
+    if(RING_SIZE - ring_used() <= RING_SLACK) {
+      /* Stop reading until the router has taken some data */
+      cur.ring_full++;
+      tun_reading = 0;
+      set_events(tun_fd, 0);
+      break;
+    }
+    n = read(tun_fd, pkt, sizeof(pkt));
+    if(n <= 0) {
+      if(n < 0 && errno != EAGAIN && errno != EINTR) {
+        die("read from %s", tun_name);
+      }
+      break;
+    }
+    ring_put_frame(pkt, n);
+    cur.tun_packets++;
+    cur.tun_bytes += n;
+    if(lat_in - lat_out < LAT_FIFO) {
+      lat_fifo[lat_in % LAT_FIFO].end = ring_tail;
+      lat_fifo[lat_in % LAT_FIFO].time = now_us();
+      lat_in++;
+    }
+  }
+  ring_flush();
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+control_input(const uint8_t *data, size_t len)
+{
+  int i;
+
+  if(data[0] == '?' && data[1] == 'P') {
+    if(verbose) {
+      fprintf(stderr, "tunslipd: prefix requested\n");
+    }
+    send_control("!P", prefix.s6_addr, 8);
+  } else if(data[0] == '!' && data[1] == 'M' && len >= 18) {
+    fprintf(stderr, "tunslipd: router MAC address ");
+    for(i = 0; i < 16; i++) {
+      fprintf(stderr, "%c%s", data[2 + i], (i & 1) && i < 15 ? ":" : "");
+    }
+    fprintf(stderr, "\n");
+  } else if(data[0] == '!' && data[1] == 'S' && len >= 2 + 7 * 4 + 4) {
+    for(i = 0; i < 7; i++) {
+      router.v[i] = get32(&data[2 + 4 * i]);
+    }
+    router.queuebuf_used = data[30];
+    router.queuebuf_total = data[31];
+    router.debug_used = data[32];
+    router.debug_total = data[33];
+    router.rtt_us = now_us() - stats_sent_at;
+    router.valid = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_frame(void *ptr, const uint8_t *data, size_t len)
+{
+  if(data[0] == '\r') {
+    fwrite(data + 1, len - 1, 1, stdout);
+    fflush(stdout);
+  } else if(len >= 2 && (data[0] == '!' || data[0] == '?')) {
+    control_input(data, len);
+  } else if((data[0] >> 4) == 6) {
+    if(write(tun_fd, data, len) != (ssize_t)len) {
+      cur.tun_drops++;
+      return;
+    }
+    cur.slip_packets++;
+    cur.slip_bytes += len;
+  } else if(verbose) {
+    fprintf(stderr, "tunslipd: ignoring %zu byte frame 0x%02x\n", len, data[0]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_input(void)
+{
+  uint8_t buf[64 * 1024];
+  ssize_t n;
+
+  n = read(slip_fd, buf, sizeof(buf));
+  if(n == 0) {
+    errno = 0;
+    die("router connection closed");
+  }
+  if(n < 0) {
+    if(errno == EAGAIN || errno == EINTR) {
+      return;
+    }
+    die("read from router");
+  }
+  slip_decoder_input(&dec, buf, n, slip_frame, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_stats(void)
+{
+  total.tun_packets += cur.tun_packets;
+  total.tun_bytes += cur.tun_bytes;
+  total.slip_packets += cur.slip_packets;
+  total.slip_bytes += cur.slip_bytes;
+  total.ring_full += cur.ring_full;
+  total.tun_drops += cur.tun_drops;
+  total.lat_count += cur.lat_count;
+  total.lat_sum += cur.lat_sum;
+  if(cur.lat_max > total.lat_max) {
+    total.lat_max = cur.lat_max;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_stats_file(double secs)
+{
+  char tmp[256];
+  FILE *f;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", stats_file);
+  f = fopen(tmp, "w");
+  if(f == NULL) {
+    return;
+  }
+  fprintf(f, "{\"interval\":%.3f,"
+          "\"tun_to_slip\":{\"packets\":%lu,\"bytes\":%lu,"
+          "\"pps\":%.1f,\"lat_avg_us\":%.1f,\"lat_max_us\":%.1f},"
+          "\"slip_to_tun\":{\"packets\":%lu,\"bytes\":%lu,\"pps\":%.1f},"
+          "\"ring_used\":%zu,\"ring_full\":%lu,\"tun_drops\":%lu,"
+          "\"crc_errors\":%lu,\"overflows\":%lu",
+          secs, total.tun_packets, total.tun_bytes, cur.tun_packets / secs,
+          cur.lat_count ? cur.lat_sum / cur.lat_count : 0.0, cur.lat_max,
+          total.slip_packets, total.slip_bytes, cur.slip_packets / secs,
+          ring_used(), total.ring_full, total.tun_drops,
+          dec.crc_errors, dec.overflows);
+  if(router.valid) {
+    fprintf(f, ",\"router\":{\"in_packets\":%u,\"in_bytes\":%u,"
+            "\"out_packets\":%u,\"out_bytes\":%u,\"no_route\":%u,"
+            "\"crc_errors\":%u,\"debug_dropped\":%u,"
+            "\"queuebuf\":[%u,%u],\"debug\":[%u,%u],\"rtt_us\":%.1f}",
+            router.v[0], router.v[1], router.v[2], router.v[3], router.v[4],
+            router.v[5], router.v[6], router.queuebuf_used,
+            router.queuebuf_total, router.debug_used, router.debug_total,
+            router.rtt_us);
+  }
+  fprintf(f, "}\n");
+  fclose(f);
+  rename(tmp, stats_file);
+}
+/*---------------------------------------------------------------------------*/
+static void
+stats_tick(void)
+{
+  static double last;
+  double now = now_us(), secs;
+
+  secs = last ? (now - last) / 1e6 : stats_interval;
+  last = now;
+  add_stats();
+
+  fprintf(stderr, "tunslipd: tun->slip %.0f pkt/s %.1f kB/s lat avg %.0f us "
+          "max %.0f us | slip->tun %.0f pkt/s %.1f kB/s | ring %zu "
+          "full %lu drops %lu crc %lu",
+          cur.tun_packets / secs, cur.tun_bytes / secs / 1e3,
+          cur.lat_count ? cur.lat_sum / cur.lat_count : 0.0, cur.lat_max,
+          cur.slip_packets / secs, cur.slip_bytes / secs / 1e3,
+          ring_used(), total.ring_full, total.tun_drops, dec.crc_errors);
+  if(router.valid) {
+    fprintf(stderr, " | router in %u out %u noroute %u q %u/%u rtt %.0f us",
+            router.v[0], router.v[2], router.v[4],
+            router.queuebuf_used, router.queuebuf_total, router.rtt_us);
+  }
+  fprintf(stderr, "\n");
+  if(stats_file != NULL) {
+    write_stats_file(secs);
+  }
+  memset(&cur, 0, sizeof(cur));
+
+  /* Poll the router counters for the next interval */
+  stats_sent_at = now_us();
+  send_control("?S", NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+static speed_t
+baud_flag(int baud)
+{
+  switch(baud) {
+  case 9600: return B9600;
+  case 19200: return B19200;
+  case 38400: return B38400;
+  case 57600: return B57600;
+  case 115200: return B115200;
+  case 230400: return B230400;
+  case 460800: return B460800;
+  case 921600: return B921600;
+  }
+  errno = 0;
+  die("unsupported baud rate %d", baud);
+  return B0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_serial(const char *dev, int baud, int flow)
+{
+  struct termios tty;
+  int fd;
+
+  fd = open(dev, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(fd < 0) {
+    die("open %s", dev);
+  }
+  if(tcgetattr(fd, &tty) < 0) {
+    die("tcgetattr %s", dev);
+  }
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, baud_flag(baud));
+  cfsetospeed(&tty, baud_flag(baud));
+  tty.c_cflag |= CLOCAL | CREAD;
+  if(flow) {
+    tty.c_cflag |= CRTSCTS;
+  } else {
+    tty.c_cflag &= ~CRTSCTS;
+  }
+  if(tcsetattr(fd, TCSAFLUSH, &tty) < 0) {
+    die("tcsetattr %s", dev);
+  }
+  return fd;
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_socket(const char *host, const char *port)
+{
+  struct addrinfo hints, *res, *r;
+  int fd = -1, one = 1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if(getaddrinfo(host, port, &hints, &res) != 0) {
+    errno = 0;
+    die("cannot resolve %s", host);
+  }
+  for(r = res; r != NULL; r = r->ai_next) {
+    fd = socket(r->ai_family, r->ai_socktype, r->ai_protocol);
+    if(fd >= 0 && connect(fd, r->ai_addr, r->ai_addrlen) == 0) {
+      break;
+    }
+    if(fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  if(fd < 0) {
+    die("connect to %s:%s", host, port);
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_tun(const char *prefix_str)
+{
+  struct ifreq ifr;
+  int fd;
+
+  fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+  if(fd < 0) {
+    die("open /dev/net/tun");
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  snprintf(ifr.ifr_name, IFNAMSIZ, "%s", tun_name);
+  if(ioctl(fd, TUNSETIFF, &ifr) < 0) {
+    die("TUNSETIFF %s", tun_name);
+  }
+  snprintf(tun_name, IFNAMSIZ, "%s", ifr.ifr_name);
+
+  ssystem("ip link set dev %s mtu %d up", tun_name, TUN_MTU);
+  ssystem("ip -6 addr add %s dev %s", prefix_str, tun_name);
+  return fd;
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options] ipv6prefix/len\n", prog);
+  fprintf(stderr, "  -s dev   serial device (/dev/ttyUSB0)\n");
+  fprintf(stderr, "  -B baud  serial speed (115200)\n");
+  fprintf(stderr, "  -H       RTS/CTS hardware flow control\n");
+  fprintf(stderr, "  -a host  connect to a serial socket instead, e.g. Cooja\n");
+  fprintf(stderr, "  -p port  serial socket port (60001)\n");
+  fprintf(stderr, "  -t tun   TUN interface name (tun0)\n");
+  fprintf(stderr, "  -c       CRC-16 framing, router built with SLIP_CRC=1\n");
+  fprintf(stderr, "  -i sec   statistics interval, 0 disables (10)\n");
+  fprintf(stderr, "  -o file  write statistics as JSON to file\n");
+  fprintf(stderr, "  -v       verbose\n");
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *dev = "/dev/ttyUSB0", *host = NULL, *port = "60001";
+  char prefix_buf[INET6_ADDRSTRLEN + 4], *slash;
+  struct epoll_event ev, events[8];
+  int baud = 115200, flow = 0, timer_fd = -1, c, i, n;
+
+  while((c = getopt(argc, argv, "s:B:Ha:p:t:ci:o:v")) != -1) {
+    switch(c) {
+    case 's': dev = optarg; break;
+    case 'B': baud = atoi(optarg); break;
+    case 'H': flow = 1; break;
+    case 'a': host = optarg; break;
+    case 'p': port = optarg; break;
+    case 't': strncpy(tun_name, optarg, IFNAMSIZ - 1); break;
+    case 'c': crc = 1; break;
+    case 'i': stats_interval = atoi(optarg); break;
+    case 'o': stats_file = optarg; break;
+    case 'v': verbose = 1; break;
+    default: usage(argv[0]);
+    }
+  }
+  if(optind != argc - 1) {
+    usage(argv[0]);
+  }
+
+  strncpy(prefix_buf, argv[optind], sizeof(prefix_buf) - 1);
+  prefix_buf[sizeof(prefix_buf) - 1] = '\0';
+  slash = strchr(prefix_buf, '/');
+  if(slash != NULL) {
+    *slash = '\0';
+    prefix_len = atoi(slash + 1);
+  }
+  if(inet_pton(AF_INET6, prefix_buf, &prefix) != 1 || prefix_len != 64) {
+    errno = 0;
+    die("expected an IPv6 /64 prefix, e.g. aaaa::1/64");
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  slip_decoder_init(&dec, crc);
+  slip_fd = host != NULL ? open_socket(host, port) : open_serial(dev, baud, flow);
+  tun_fd = open_tun(argv[optind]);
+
+  epoll_fd = epoll_create1(0);
+  ev.events = EPOLLIN;
+  ev.data.fd = tun_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, tun_fd, &ev);
+  ev.data.fd = slip_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, slip_fd, &ev);
+  if(stats_interval > 0) {
+    struct itimerspec its = { { stats_interval, 0 }, { stats_interval, 0 } };
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    timerfd_settime(timer_fd, 0, &its, NULL);
+    ev.data.fd = timer_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev);
+  }
+
+  fprintf(stderr, "tunslipd: %s <-> %s%s%s, prefix %s\n", tun_name,
+          host ? host : dev, host ? ":" : "", host ? port : "", argv[optind]);
+  send_control("?M", NULL, 0);
+
+  while(1) {
+    n = epoll_wait(epoll_fd, events, 8, -1);
+    if(n < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      die("epoll_wait");
+    }
+    for(i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+      if(fd == slip_fd) {
+        if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          slip_input();
+        }
+        if(events[i].events & EPOLLOUT) {
+          ring_flush();
+        }
+      } else if(fd == tun_fd) {
+        tun_input();
+      } else if(fd == timer_fd) {
+        uint64_t expirations;
+        if(read(timer_fd, &expirations, sizeof(expirations)) > 0) {
+          stats_tick();
+        }
+      }
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/